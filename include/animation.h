@@ -0,0 +1,64 @@
+/* =====================================================================================================================
+ *      File:  /include/animation.h
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef ANIMATION_H
+#define ANIMATION_H
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "Arduino.h"
+
+#include "library.h"
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+typedef struct
+{
+	uint32_t frames;            // Frames drawn and committed since the animation started.
+	uint32_t dropped;           // Frames skipped because the one after them was already due, or replaced while
+	                            // their commit was put off.
+	uint32_t deferred;          // Frames whose commit was put off because the output core still held every buffer.
+	                            // They count towards frames and late once the retried commit goes out.
+	uint32_t late;              // Frames committed more than half a frame time after they were due.
+	uint32_t late_max_us;       // Worst time from a frame being due to it being committed.
+	uint32_t render_last_us;    // Time taken to draw and commit the most recent frame.
+	uint32_t render_max_us;
+} AnimationStats_t;
+
+
+
+
+//======================================================================================================================
+// Functions
+//----------------------------------------------------------------------------------------------------------------------
+void animation_play(const LibraryImage_t * image);
+void animation_service(void);
+bool animation_playing(void);
+const AnimationStats_t * animation_stats(void);
+
+
+
+
+#endif
+/* End of File */
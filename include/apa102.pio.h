@@ -73,9 +73,9 @@ static const uint16_t apa102_rgb555_program_instructions[] = {
             //     .wrap_target
     0x80e0, //  0: pull   ifempty block
     0xe022, //  1: set    x, 2
-    0x40e5, //  2: in     osr, 5
-    0x6065, //  3: out    null, 5
-    0x4063, //  4: in     null, 3
+    0x4063, //  2: in     null, 3
+    0x40e5, //  3: in     osr, 5
+    0x6065, //  4: out    null, 5
     0x0042, //  5: jmp    x--, 2
     0x4048, //  6: in     y, 8
     0xa0d6, //  7: mov    isr, ::isr
@@ -101,4 +101,47 @@ static inline pio_sm_config apa102_rgb555_program_get_default_config(uint offset
     sm_config_set_wrap(&c, offset + apa102_rgb555_wrap_target, offset + apa102_rgb555_wrap);
     return c;
 }
+
+#include "hardware/clocks.h"
+static inline void apa102_rgb555_program_init(PIO pio, uint sm, uint offset,
+        uint baud, uint pin_clk, uint pin_din) {
+    pio_sm_set_pins_with_mask(pio, sm, 0, (1u << pin_clk) | (1u << pin_din));
+    pio_sm_set_pindirs_with_mask(pio, sm, ~0u, (1u << pin_clk) | (1u << pin_din));
+    pio_gpio_init(pio, pin_clk);
+    pio_gpio_init(pio, pin_din);
+
+    pio_sm_config c = apa102_rgb555_program_get_default_config(offset);
+    sm_config_set_out_pins(&c, pin_din, 1);
+    sm_config_set_set_pins(&c, pin_clk, 1);
+    // Shift both to right, no autopull or autopush
+    sm_config_set_out_shift(&c, true, false, 32);
+    sm_config_set_in_shift(&c, true, false, 32);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+    // Each bit takes 17 execution cycles in bit_out
+    float div = (float)clock_get_hz(clk_sys) / (17 * baud);
+    sm_config_set_clkdiv(&c, div);
+
+    pio_sm_init(pio, sm, offset, &c);
+    pio_sm_set_enabled(pio, sm, true);
+}
+
+// Load the 5-bit global brightness into Y as the 111bbbbb byte pixel_out sends first.  The state machine must be idle,
+// waiting for pixel data with an empty FIFO.
+static inline void apa102_rgb555_set_brightness(PIO pio, uint sm, uint8_t brightness) {
+    // Stop the program so it can't pull the value as pixel data
+    pio_sm_set_enabled(pio, sm, false);
+    pio_sm_put(pio, sm, 0xe0 | (brightness & 0x1f));
+    pio_sm_exec(pio, sm, pio_encode_pull(false, true));
+    pio_sm_exec(pio, sm, pio_encode_mov(pio_y, pio_osr));
+    // Leave the OSR empty so pixel_out pulls fresh data
+    pio_sm_exec(pio, sm, pio_encode_out(pio_null, 32));
+    pio_sm_set_enabled(pio, sm, true);
+}
+
+// The program only emits pixels, so shift a start frame out of a cleared ISR before pixel data is written.  The state
+// machine must be stalled waiting for pixel data.
+static inline void apa102_rgb555_start_frame(PIO pio, uint sm, uint offset) {
+    pio_sm_exec(pio, sm, pio_encode_mov(pio_isr, pio_null));
+    pio_sm_exec(pio, sm, pio_encode_jmp(offset + apa102_rgb555_offset_bit_run));
+}
 #endif
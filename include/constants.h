@@ -32,6 +32,38 @@
 
 #define SERIAL_FREQ (16 * 1000 * 1000)
 
+// Column output engine.  Polled re-arms the LED DMA from loop1() each time rtt_column() changes.  Streamed has a PIO
+// pacer, restarted at every hall pulse, walk a DMA list of column addresses so a revolution needs no CPU at all.
+#define COLUMN_OUTPUT_POLLED 0
+#define COLUMN_OUTPUT_STREAMED 1
+#define COLUMN_OUTPUT COLUMN_OUTPUT_POLLED
+
+// Frame storage and LED PIO program.  APA102 keeps frames as ready-to-send wire words for apa102_mini.  RGB555 packs
+// two pixels per word for apa102_rgb555, halving frame memory, with brightness loaded into the state machines at run
+// time.  Indexed keeps one palette index byte per pixel and resolves each column to APA102 words just before it is
+// sent, so a color change is a palette write that needs no redraw.  RGB555 and indexed are only supported by the
+// polled column output.
+#define PIXEL_FORMAT_APA102 0
+#define PIXEL_FORMAT_RGB555 1
+#define PIXEL_FORMAT_INDEXED 2
+#define PIXEL_FORMAT PIXEL_FORMAT_APA102
+
+// Region image source for the renderer.  Spans fill runs of rows per column from tables made by tools/spangen.py.
+// Labels look every pixel up in a single region number plane made by tools/labelgen.py, through a palette built from
+// the active flags.
+#define IMAGE_FORMAT_SPANS 0
+#define IMAGE_FORMAT_LABELS 1
+#define IMAGE_FORMAT IMAGE_FORMAT_SPANS
+
+// Labels an image may use, the background included.  Library images with more colors are refused by the packer.
+#define PALETTE_SIZE 64
+
+// Image library made by tools/imagepack.py, written to its own flash range so content can change without reflashing
+// the firmware: `picotool load -t bin -o 0x10100000 library.bin`.  The range must stay clear of the firmware and of
+// the EEPROM emulation sector at the very end of the Pico W's 2 MB.
+#define LIBRARY_FLASH_OFFSET (1024 * 1024)
+#define LIBRARY_FLASH_SIZE (512 * 1024)
+
 // Global brightness value 0->31
 #define BRIGHTNESS 6
 
@@ -41,6 +73,19 @@
 
 #define INACTIVE_COLOR 0x00050505
 
+// Milliseconds each frame of a library animation is shown for when the library doesn't say.
+#define ANIMATION_FRAME_TIME 100
+
+// WebSocket push channel.  Reconnect attempts are spaced by PUSH_RETRY_TIME, polling every REFRESH_TIME in between.
+#define PUSH_RETRY_TIME 30000
+#define PUSH_PING_TIME 15000
+#define PUSH_CONNECT_TIMEOUT 2000
+
+// Largest response body kept from the server, read straight off the socket into a static buffer.
+#define RESPONSE_BUFFER_SIZE 64
+// Longest ETag or Last-Modified value remembered to make the next request conditional.
+#define VALIDATOR_SIZE 48
+
 
 
 
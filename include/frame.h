@@ -0,0 +1,193 @@
+/* =====================================================================================================================
+ *      File:  /include/frame.h
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef FRAME_H
+#define FRAME_H
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "Arduino.h"
+
+#include "constants.h"
+
+
+
+
+//======================================================================================================================
+// Definitions
+//----------------------------------------------------------------------------------------------------------------------
+#if PIXEL_FORMAT == PIXEL_FORMAT_RGB555
+// Two RGB555 pixels per word (far end of the strip first), then one spare word to clock the last pixels through.
+// The start frame is generated by the PIO program.
+static_assert(LED_COUNT % 2 == 0, "RGB555 columns pack two LEDs per word");
+#define COLUMN_WORDS (LED_COUNT / 2 + 1)
+#else
+// Start frame, LED_COUNT APA102 pixels (far end first), end frame.
+#define COLUMN_WORDS COLUMN_BUFFER_SIZE
+#endif
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// One half of the strip exactly as it is handed to the LED DMA channel.
+typedef uint32_t Column_t[COLUMN_WORDS];
+
+#if PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+// Palette indices for one half of the strip, far end first like the pixels of a Column_t.  Index 0 is the background.
+// Up to 256 entries are addressable, the 17 the regions need (16 plus background) would not fit in a nibble.
+typedef uint8_t IndexColumn_t[LED_COUNT];
+typedef IndexColumn_t FrameColumn_t;
+#else
+typedef Column_t FrameColumn_t;
+#endif
+
+// Frames are stored column-major in output format and pre-split into the half shown by each side of the strip so that
+// the output core only has to point the DMA at the correct column.  Indexed frames need resolving through the palette
+// first, see frame_resolve_column().
+typedef struct
+{
+	FrameColumn_t left[RES_HORIZ];
+	FrameColumn_t right[RES_HORIZ];
+} Frame_t;
+
+
+
+
+//======================================================================================================================
+// Inline Helpers
+//----------------------------------------------------------------------------------------------------------------------
+static inline uint32_t convert_rgb_to_apa102(uint32_t value)
+{
+	uint8_t red = (value >> 16) & 0xFF;
+	uint8_t green = (value >> 8) & 0xFF;
+	uint8_t blue = value & 0xFF;
+
+	uint32_t apa102 = 0x7 << 29
+		| (BRIGHTNESS & 0x1f) << 24
+		| (uint32_t) blue << 16
+		| (uint32_t) green << 8
+		| (uint32_t) red << 0;
+
+	return apa102;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Pack the top 5 bits of each channel red lowest, 0BBBBBGGGGGRRRRR, the order apa102_rgb555 takes them in. */
+static inline uint32_t convert_rgb_to_rgb555(uint32_t value)
+{
+	uint8_t red = (value >> 19) & 0x1F;
+	uint8_t green = (value >> 11) & 0x1F;
+	uint8_t blue = (value >> 3) & 0x1F;
+
+	return (uint32_t) blue << 10 | (uint32_t) green << 5 | red;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Convert a 24-bit RGB color into a pixel in the frame's output format, or into a palette entry for indexed frames. */
+static inline uint32_t frame_convert(uint32_t color)
+{
+#if PIXEL_FORMAT == PIXEL_FORMAT_RGB555
+	return convert_rgb_to_rgb555(color);
+#else
+	return convert_rgb_to_apa102(color);
+#endif
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Merge an already converted pixel into the provided column and row of the frame.
+ *
+ * Odd rows are shown by the left half of the strip and even rows by the right, both wired from the far end.  Both
+ * formats keep the channels in separate bit fields so OR-ing output words has the same effect as OR-ing RGB values.
+ */
+static inline void frame_merge(Frame_t * frame, uint8_t column, uint8_t row, uint32_t pixel)
+{
+	FrameColumn_t * half = (row & 1) ? &frame->left[column] : &frame->right[column];
+
+#if PIXEL_FORMAT == PIXEL_FORMAT_RGB555
+	uint8_t position = LED_COUNT - 1 - row / 2;
+	(*half)[position / 2] |= pixel << ((position & 1) * 16);
+#elif PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+	// Stored rather than merged, or two indices landing on one pixel would make one that is off the end of the palette.
+	(*half)[LED_COUNT - 1 - row / 2] = pixel;
+#else
+	(*half)[LED_COUNT - row / 2] |= pixel;
+#endif
+}
+
+
+#if PIXEL_FORMAT != PIXEL_FORMAT_INDEXED
+//----------------------------------------------------------------------------------------------------------------------
+/* Merge a color into the pixel at the provided column and row of the frame.  Indexed frames have no colors to merge,
+ * only palette indices.
+ */
+static inline void frame_set_pixel(Frame_t * frame, uint8_t column, uint8_t row, uint32_t color)
+{
+	frame_merge(frame, column, row, frame_convert(color));
+}
+#endif
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Merge an already converted pixel, or a palette index, into length consecutive rows of a column, starting at row. */
+static inline void frame_fill_span(Frame_t * frame, uint8_t column, uint8_t row, uint8_t length, uint32_t pixel)
+{
+	for (uint8_t end = row + length; row < end; row++)
+	{
+		frame_merge(frame, column, row, pixel);
+	}
+}
+
+
+#if PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+//----------------------------------------------------------------------------------------------------------------------
+/* Look each index of a frame column up in a palette of APA102 words, filling the pixels of a column buffer.  The start
+ * and end frames are left alone, set them once with frame_clear_column().
+ */
+static inline void frame_resolve_column(const IndexColumn_t * indices, const uint32_t * palette, Column_t * column)
+{
+	for (uint8_t idx = 0; idx < LED_COUNT; idx++)
+	{
+		(*column)[idx + 1] = palette[(*indices)[idx]];
+	}
+}
+#endif
+
+
+
+//======================================================================================================================
+// Functions
+//----------------------------------------------------------------------------------------------------------------------
+void frame_clear_column(Column_t * column);
+#if PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+void frame_clear_column(IndexColumn_t * column);
+#endif
+void frame_clear(Frame_t * frame);
+
+
+
+
+#endif
+/* End of File */
@@ -46,6 +46,36 @@
 //----------------------------------------------------------------------------------------------------------------------
 typedef uint8_t Region_t[REGION_WIDTH][REGION_BYTES];
 
+// A vertical run of set pixels within one column of a region.
+typedef struct
+{
+	uint8_t row;
+	uint8_t length;
+} Span_t;
+
+// A region as runs of pixels, generated from the Region_t bitmaps by tools/spangen.py.  Only the columns from
+// first_column to the last non-empty one are stored.  The spans of column first_column + n are spans[index[n]] up to
+// spans[index[n + 1]].
+typedef struct
+{
+	uint8_t first_column;
+	uint8_t column_count;
+	const uint16_t * index;
+	const Span_t * spans;
+} RegionSpans_t;
+
+// Region number plus one of every pixel, 0 where there is no region, generated from the Region_t bitmaps by
+// tools/labelgen.py.  Regions never overlap so a single plane holds them all.  16 regions and the background need 17
+// values, one too many for 4 bits, so labels take a byte each.
+typedef uint8_t LabelMap_t[REGION_WIDTH][REGION_HEIGHT];
+
+// Columns of the label map a region covers.
+typedef struct
+{
+	uint8_t first_column;
+	uint8_t column_count;
+} RegionExtent_t;
+
 
 
 
@@ -54,6 +84,9 @@ typedef uint8_t Region_t[REGION_WIDTH][REGION_BYTES];
 //----------------------------------------------------------------------------------------------------------------------
 extern const uint32_t ColorMap[];
 extern const Region_t * Regions[];
+extern const RegionSpans_t RegionSpans[];
+extern const LabelMap_t LabelMap;
+extern const RegionExtent_t RegionExtents[];
 
 
 
@@ -0,0 +1,105 @@
+/* =====================================================================================================================
+ *      File:  /include/library.h
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef LIBRARY_H
+#define LIBRARY_H
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "Arduino.h"
+
+#include "constants.h"
+
+
+
+
+//======================================================================================================================
+// Definitions
+//----------------------------------------------------------------------------------------------------------------------
+#define LIBRARY_MAGIC 0x4C475650  // "PVGL"
+#define LIBRARY_VERSION 1
+#define LIBRARY_NAME_SIZE 16
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// The library is packed by tools/imagepack.py, little-endian, with every offset counted from the start of the header.
+//
+// Each frame starts with RES_HORIZ + 1 16-bit offsets, from the frame start to the runs of each column and finally
+// to the end of the last one.  A run is two bytes, a length in rows then a label, and a column's runs cover its
+// RES_VERT rows from the top down.  Label 0 is the background, label n is drawn in color n - 1, and labels up to
+// REGION_COUNT follow the region flags like the built-in regions do.
+typedef struct
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t image_count;
+	uint32_t size;              // Bytes in the whole library, header included.
+} LibraryHeader_t;
+
+typedef struct
+{
+	char name[LIBRARY_NAME_SIZE];  // NUL padded, not terminated when all LIBRARY_NAME_SIZE characters are used.
+	uint16_t frame_count;
+	uint16_t frame_time;        // Milliseconds each frame of an animation is shown for.
+	uint8_t color_count;
+	uint8_t reserved[3];
+	uint32_t colors;            // Offset of color_count 24-bit RGB colors, one word each.
+	uint32_t frames;            // Offset of frame_count frame offsets, one word each.
+} LibraryImage_t;
+
+
+
+
+//======================================================================================================================
+// Inline Helpers
+//----------------------------------------------------------------------------------------------------------------------
+/* Find the runs of one column of a frame returned by library_frame().  Returns the first run and sets end just past
+ * the last.
+ */
+static inline const uint8_t * library_column(const uint8_t * frame, uint8_t column, const uint8_t ** end)
+{
+	const uint16_t * columns = (const uint16_t *)frame;
+
+	*end = frame + columns[column + 1];
+	return frame + columns[column];
+}
+
+
+
+
+//======================================================================================================================
+// Functions
+//----------------------------------------------------------------------------------------------------------------------
+bool library_setup(const uint8_t * base, uint32_t size);
+uint16_t library_count(void);
+const LibraryImage_t * library_image(uint16_t index);
+const LibraryImage_t * library_find(const char * name, size_t length);
+const uint32_t * library_colors(const LibraryImage_t * image);
+const uint8_t * library_frame(const LibraryImage_t * image, uint16_t frame);
+
+
+
+
+#endif
+/* End of File */
@@ -0,0 +1,48 @@
+// -------------------------------------------------- //
+// This file is autogenerated by pioasm; do not edit! //
+// -------------------------------------------------- //
+
+#pragma once
+
+#if !PICO_NO_HARDWARE
+#include "hardware/pio.h"
+#endif
+
+// ------------ //
+// column_pacer //
+// ------------ //
+
+#define column_pacer_wrap_target 0
+#define column_pacer_wrap 4
+
+static const uint16_t column_pacer_program_instructions[] = {
+            //     .wrap_target
+    0x8080, //  0: pull   noblock
+    0xa027, //  1: mov    x, osr
+    0x8000, //  2: push   noblock
+    0xa041, //  3: mov    y, x
+    0x0084, //  4: jmp    y--, 4
+            //     .wrap
+};
+
+#if !PICO_NO_HARDWARE
+static const struct pio_program column_pacer_program = {
+    .instructions = column_pacer_program_instructions,
+    .length = 5,
+    .origin = -1,
+};
+
+static inline pio_sm_config column_pacer_program_get_default_config(uint offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + column_pacer_wrap_target, offset + column_pacer_wrap);
+    return c;
+}
+
+static inline void column_pacer_program_init(PIO pio, uint sm, uint offset) {
+    pio_sm_config c = column_pacer_program_get_default_config(offset);
+    // Run at the full system clock so a period maps directly onto cycles
+    sm_config_set_clkdiv(&c, 1.0f);
+    pio_sm_init(pio, sm, offset, &c);
+}
+
+#endif
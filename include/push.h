@@ -0,0 +1,43 @@
+/* =====================================================================================================================
+ *      File:  /include/push.h
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef PUSH_H
+#define PUSH_H
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "Arduino.h"
+#include <ArduinoHttpClient.h>
+
+
+
+
+//======================================================================================================================
+// Functions
+//----------------------------------------------------------------------------------------------------------------------
+void push_setup(WebSocketClient * socket, const char * path);
+int push_poll(uint8_t * message, size_t size);
+bool push_connected(void);
+
+
+
+
+#endif
+/* End of File */
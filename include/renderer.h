@@ -0,0 +1,72 @@
+/* =====================================================================================================================
+ *      File:  /include/renderer.h
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef RENDERER_H
+#define RENDERER_H
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "Arduino.h"
+
+#include "frame.h"
+#include "library.h"
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+typedef struct
+{
+	uint32_t published;         // Frames committed by the renderer.
+	uint32_t shown;             // Frames taken up by the output core.
+	uint32_t skipped;           // Frames replaced by a newer one before the output core took them.
+	uint32_t deferred;          // Commits put off because the output core held every free buffer, counted once
+	                            // however many retries it took to publish them.
+} RendererStats_t;
+
+
+
+
+//======================================================================================================================
+// Functions
+//----------------------------------------------------------------------------------------------------------------------
+void renderer_setup(void);
+void renderer_set_regions(const uint8_t * active_regions);
+void renderer_set_region(uint8_t region, bool active);
+void renderer_set_image(const LibraryImage_t * image, uint16_t frame);
+void renderer_invalidate(uint8_t first, uint8_t count);
+bool renderer_commit(void);
+bool renderer_pending(void);
+const Frame_t * renderer_acquire(void);
+void renderer_release(void);
+const Frame_t * renderer_frame(void);
+uint32_t renderer_sequence(void);
+const RendererStats_t * renderer_stats(void);
+#if PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+const uint32_t * renderer_palette(void);
+#endif
+
+
+
+
+#endif
+/* End of File */
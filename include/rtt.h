@@ -31,10 +31,33 @@
 
 
 
+//======================================================================================================================
+// Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Fixed-point fractional bits of rtt_period() (microseconds) and rtt_phase() (columns).
+#define RTT_PERIOD_SHIFT 8
+#define RTT_PHASE_SHIFT 8
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Called from the hall sensor IRQ at the start of every revolution with the predicted revolution time in microseconds.
+typedef void (*rtt_index_callback_t)(uint32_t period);
+
+
+
+
 //======================================================================================================================
 // Functions
 //----------------------------------------------------------------------------------------------------------------------
 void rtt_setup(void);
+void rtt_set_index_callback(rtt_index_callback_t callback);
+uint32_t rtt_period(void);
+uint32_t rtt_phase(void);
+uint32_t rtt_revolution(void);
 uint8_t rtt_column(void);
 bool rtt_rotating(void);
 
@@ -0,0 +1,65 @@
+/* =====================================================================================================================
+ *      File:  /include/session.h
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef SESSION_H
+#define SESSION_H
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "Arduino.h"
+#include <ArduinoHttpClient.h>
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+typedef struct
+{
+	uint32_t requests;          // Requests that completed with a response.
+	uint32_t reused;            // ...of which were sent over an already open connection.
+	uint32_t unchanged;         // ...of which were answered 304 Not Modified, with no body.
+	uint32_t connects;          // Connections opened or attempted, including reconnects.
+	uint32_t retries;           // Requests repeated on a fresh connection after a reused one failed.
+	uint32_t failures;          // Requests that got no usable response at all.
+	uint32_t latency_last_us;   // Request start to end of body, most recent completed request.
+	uint32_t latency_max_us;
+	uint64_t latency_total_us;  // Divide by requests for the mean.
+} SessionStats_t;
+
+
+
+
+//======================================================================================================================
+// Functions
+//----------------------------------------------------------------------------------------------------------------------
+void session_setup(HttpClient * http);
+int session_begin(const char * path, uint8_t * body, size_t size);
+int session_poll(int * length);
+bool session_busy(void);
+void session_forget(void);
+const SessionStats_t * session_stats(void);
+
+
+
+
+#endif
+/* End of File */
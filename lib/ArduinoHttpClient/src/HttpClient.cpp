@@ -7,12 +7,11 @@
 
 // Initialize constants
 const char* HttpClient::kUserAgent = "Arduino/2.2.0";
-const char* HttpClient::kContentLengthPrefix = HTTP_HEADER_CONTENT_LENGTH ": ";
-const char* HttpClient::kTransferEncodingChunked = HTTP_HEADER_TRANSFER_ENCODING ": " HTTP_HEADER_VALUE_CHUNKED;
 
 HttpClient::HttpClient(Client& aClient, const char* aServerName, uint16_t aServerPort)
  : iClient(&aClient), iServerName(aServerName), iServerAddress(), iServerPort(aServerPort),
-   iConnectionClose(true), iSendDefaultRequestHeaders(true)
+   iConnectionClose(true), iSendDefaultRequestHeaders(true),
+   iWatchedHeaders(NULL), iWatchedCount(0)
 {
   resetState();
 }
@@ -24,7 +23,8 @@ HttpClient::HttpClient(Client& aClient, const String& aServerName, uint16_t aSer
 
 HttpClient::HttpClient(Client& aClient, const IPAddress& aServerAddress, uint16_t aServerPort)
  : iClient(&aClient), iServerName(NULL), iServerAddress(aServerAddress), iServerPort(aServerPort),
-   iConnectionClose(true), iSendDefaultRequestHeaders(true)
+   iConnectionClose(true), iSendDefaultRequestHeaders(true),
+   iWatchedHeaders(NULL), iWatchedCount(0)
 {
   resetState();
 }
@@ -32,13 +32,22 @@ HttpClient::HttpClient(Client& aClient, const IPAddress& aServerAddress, uint16_
 void HttpClient::resetState()
 {
   iState = eIdle;
+  iRequestLength = 0;
   iStatusCode = 0;
+  iBodyStored = 0;
+  iLastProgress = 0;
   iContentLength = kNoContentLengthHeader;
   iBodyLengthConsumed = 0;
-  iContentLengthPtr = kContentLengthPrefix;
-  iTransferEncodingChunkedPtr = kTransferEncodingChunked;
   iIsChunked = false;
   iChunkLength = 0;
+  iChunkLengthDigits = false;
+  iHeaderStart = 0;
+  iHeaderEnd = 0;
+  iHeaderSkipping = false;
+  iHeaderLine = NULL;
+  iHeaderLineLength = 0;
+  iHeaderLinePos = 0;
+  iHeaderValuesLength = 0;
   iHttpResponseTimeout = kHttpResponseTimeout;
   iHttpWaitForDataDelay = kHttpWaitForDataDelay;
 }
@@ -61,13 +70,20 @@ void HttpClient::noDefaultRequestHeaders()
 
 void HttpClient::beginRequest()
 {
+  if (endOfHeadersReached())
+  {
+    // As startRequest() would, let go of the last response on a connection
+    // being kept alive, or its Content-Length would apply to the next one
+    flushClientRx();
+    resetState();
+  }
   iState = eRequestStarted;
 }
 
 int HttpClient::startRequest(const char* aURLPath, const char* aHttpMethod, 
                                 const char* aContentType, int aContentLength, const byte aBody[])
 {
-    if (iState == eReadingBody || iState == eReadingChunkLength || iState == eReadingBodyChunk)
+    if (endOfHeadersReached())
     {
         flushClientRx();
 
@@ -130,15 +146,16 @@ int HttpClient::startRequest(const char* aURLPath, const char* aHttpMethod,
 
         if (initialState == eIdle || hasBody)
         {
-            // This was a simple version of the API, so terminate the headers now
-            finishHeaders();
+            // This was a simple version of the API, so terminate the headers
+            // now, sending the body along with them if there is room
+            endHeaders();
+            if (hasBody)
+            {
+                queueRequest((const char*)aBody, aContentLength);
+            }
+            flushRequest();
         }
         // else we'll call it in endRequest or in the first call to print, etc.
-
-        if (hasBody)
-        {
-                write(aBody, aContentLength);
-        }
     }
 
     return ret;
@@ -150,24 +167,25 @@ int HttpClient::sendInitialHeaders(const char* aURLPath, const char* aHttpMethod
     Serial.println("Connected");
 #endif
     // Send the HTTP command, i.e. "GET /somepath/ HTTP/1.0"
-    iClient->print(aHttpMethod);
-    iClient->print(" ");
+    iRequestLength = 0;
+    queueRequest(aHttpMethod);
+    queueRequest(" ");
 
-    iClient->print(aURLPath);
-    iClient->println(" HTTP/1.1");
+    queueRequest(aURLPath);
+    queueRequest(" HTTP/1.1\r\n");
     if (iSendDefaultRequestHeaders)
     {
         // The host header, if required
         if (iServerName)
         {
-            iClient->print("Host: ");
-            iClient->print(iServerName);
+            queueRequest("Host: ");
+            queueRequest(iServerName);
             if (iServerPort != kHttpPort && iServerPort != kHttpsPort)
             {
-              iClient->print(":");
-              iClient->print(iServerPort);
+              queueRequest(":");
+              queueRequest((long)iServerPort);
             }
-            iClient->println();
+            queueRequest("\r\n");
         }
         // And user-agent string
         sendHeader(HTTP_HEADER_USER_AGENT, kUserAgent);
@@ -187,27 +205,30 @@ int HttpClient::sendInitialHeaders(const char* aURLPath, const char* aHttpMethod
 
 void HttpClient::sendHeader(const char* aHeader)
 {
-    iClient->println(aHeader);
+    queueRequest(aHeader);
+    queueRequest("\r\n");
 }
 
 void HttpClient::sendHeader(const char* aHeaderName, const char* aHeaderValue)
 {
-    iClient->print(aHeaderName);
-    iClient->print(": ");
-    iClient->println(aHeaderValue);
+    queueRequest(aHeaderName);
+    queueRequest(": ");
+    queueRequest(aHeaderValue);
+    queueRequest("\r\n");
 }
 
 void HttpClient::sendHeader(const char* aHeaderName, const int aHeaderValue)
 {
-    iClient->print(aHeaderName);
-    iClient->print(": ");
-    iClient->println(aHeaderValue);
+    queueRequest(aHeaderName);
+    queueRequest(": ");
+    queueRequest((long)aHeaderValue);
+    queueRequest("\r\n");
 }
 
 void HttpClient::sendBasicAuth(const char* aUser, const char* aPassword)
 {
     // Send the initial part of this header line
-    iClient->print("Authorization: Basic ");
+    queueRequest("Authorization: Basic ");
     // Now Base64 encode "aUser:aPassword" and send that
     // This seems trickier than it should be but it's mostly to avoid either
     // (a) some arbitrarily sized buffer which hopes to be big enough, or
@@ -216,7 +237,7 @@ void HttpClient::sendBasicAuth(const char* aUser, const char* aPassword)
     // go.
     // In Base64, each 3 bytes of unencoded data become 4 bytes of encoded data
     unsigned char input[3];
-    unsigned char output[5]; // Leave space for a '\0' terminator so we can easily print
+    unsigned char output[4];
     int userLen = strlen(aUser);
     int passwordLen = strlen(aPassword);
     int inputOffset = 0;
@@ -240,23 +261,78 @@ void HttpClient::sendBasicAuth(const char* aUser, const char* aPassword)
         {
             // We've either got to a 3-byte boundary, or we've reached then end
             b64_encode(input, inputOffset, output, 4);
-            // NUL-terminate the output string
-            output[4] = '\0';
-            // And write it out
-            iClient->print((char*)output);
+            // And add it to the request
+            queueRequest((const char*)output, 4);
 // FIXME We might want to fill output with '=' characters if b64_encode doesn't
 // FIXME do it for us when we're encoding the final chunk
             inputOffset = 0;
         }
     }
     // And end the header we've sent
-    iClient->println();
+    queueRequest("\r\n");
 }
 
 void HttpClient::finishHeaders()
 {
-    iClient->println();
-    iState = eRequestSent;
+    endHeaders();
+    flushRequest();
+}
+
+void HttpClient::endHeaders()
+{
+    queueRequest("\r\n");
+    startResponse();
+}
+
+void HttpClient::queueRequest(const char* aData, size_t aLength)
+{
+    while (aLength)
+    {
+        if (iRequestLength == kRequestBufferSize)
+        {
+            // Too long to send in one go, stream out what we have so far
+            flushRequest();
+        }
+        size_t room = kRequestBufferSize - iRequestLength;
+        size_t count = (aLength < room) ? aLength : room;
+        memcpy(iRequestBuffer + iRequestLength, aData, count);
+        iRequestLength += count;
+        aData += count;
+        aLength -= count;
+    }
+}
+
+void HttpClient::queueRequest(const char* aText)
+{
+    queueRequest(aText, strlen(aText));
+}
+
+void HttpClient::queueRequest(long aValue)
+{
+    // Each byte of a long adds under 3 decimal digits, leaving room for
+    // the sign and one more
+    char digits[3 * sizeof(long) + 2];
+    char* start = digits + sizeof(digits);
+    unsigned long magnitude = (aValue < 0) ? -(unsigned long)aValue : aValue;
+    do
+    {
+        *--start = '0' + (magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (aValue < 0)
+    {
+        *--start = '-';
+    }
+    queueRequest(start, digits + sizeof(digits) - start);
+}
+
+void HttpClient::flushRequest()
+{
+    if (iRequestLength)
+    {
+        iClient->write((const uint8_t*)iRequestBuffer, iRequestLength);
+        iRequestLength = 0;
+    }
 }
 
 void HttpClient::flushClientRx()
@@ -393,6 +469,27 @@ int HttpClient::del(const char* aURLPath, const char* aContentType, int aContent
 }
 
 int HttpClient::responseStatusCode()
+{
+    if (iState < eRequestSent)
+    {
+        return HTTP_ERROR_API;
+    }
+
+    iLastProgress = millis();
+    int ret;
+    while ((ret = pollStatusCode()) == HTTP_PENDING)
+    {
+        if (responseTimedOut())
+        {
+            return HTTP_ERROR_TIMED_OUT;
+        }
+        // We haven't got any data, so let's pause to allow some to arrive
+        delay(iHttpWaitForDataDelay);
+    }
+    return ret;
+}
+
+int HttpClient::pollStatusCode()
 {
     if (iState < eRequestSent)
     {
@@ -403,144 +500,283 @@ int HttpClient::responseStatusCode()
     // Where HTTP-Version is of the form:
     //   HTTP-Version   = "HTTP" "/" 1*DIGIT "." 1*DIGIT
 
-    int c = '\0';
-    do
+    while (iState == eRequestSent)
     {
-        // Make sure the status code is reset, and likewise the state.  This
-        // lets us easily cope with 1xx informational responses by just
-        // ignoring them really, and reading the next line for a proper response
+        char* line;
+        size_t length;
+        if (scanLine(&line, &length) != HTTP_SUCCESS)
+        {
+            // Nothing more to go on, unless the server closed the connection
+            // part way through
+            return iClient->connected() ? HTTP_PENDING : HTTP_ERROR_INVALID_RESPONSE;
+        }
+        if (length == 0)
+        {
+            // The blank line ending an informational response
+            continue;
+        }
+        if ((length < 9) || (strncmp(line, "HTTP/", 5) != 0) || (line[6] != '.') || (line[8] != ' '))
+        {
+            // This wasn't a properly formed status line, or at least not
+            // one we could understand
+            return HTTP_ERROR_INVALID_RESPONSE;
+        }
+
+        // We could sanity check the status code, but let's be lenient
         iStatusCode = 0;
-        iState = eRequestSent;
+        for (size_t idx = 9; (idx < length) && isdigit(line[idx]); idx++)
+        {
+            iStatusCode = iStatusCode*10 + (line[idx] - '0');
+        }
+        if ((iStatusCode >= 200) || (iStatusCode == 101))
+        {
+            // We've read the status-line successfully, an informational
+            // (1xx) one is ignored and the next line read for a proper
+            // response
+            iState = eStatusCodeRead;
+        }
+    }
+    return iStatusCode;
+}
+
+int HttpClient::skipResponseHeaders()
+{
+    // Just keep reading until we finish reading the headers or time out
+    iLastProgress = millis();
+    int ret;
+    while ((ret = pollHeaders()) == HTTP_PENDING)
+    {
+        if (responseTimedOut())
+        {
+            return HTTP_ERROR_TIMED_OUT;
+        }
+        // We haven't got any data, so let's pause to allow some to arrive
+        delay(iHttpWaitForDataDelay);
+    }
+    return ret;
+}
 
-        unsigned long timeoutStart = millis();
-        // Psuedo-regexp we're expecting before the status-code
-        const char* statusPrefix = "HTTP/*.* ";
-        const char* statusPtr = statusPrefix;
-        // Whilst we haven't timed out & haven't reached the end of the headers
-        while ((c != '\n') && 
-               ( (millis() - timeoutStart) < iHttpResponseTimeout ))
+int HttpClient::pollHeaders()
+{
+    while (!endOfHeadersReached())
+    {
+        char* line;
+        size_t length;
+        if (scanHeader(&line, &length) != HTTP_SUCCESS)
         {
-            if (available())
+            // Nothing more to go on, unless the server closed the connection
+            // part way through
+            return iClient->connected() ? HTTP_PENDING : HTTP_ERROR_INVALID_RESPONSE;
+        }
+    }
+    return HTTP_SUCCESS;
+}
+
+int HttpClient::scanLine(char** aLine, size_t* aLength)
+{
+    while (true)
+    {
+        char* start = iHeaderBuffer + iHeaderStart;
+        char* end = (char*)memchr(start, '\n', iHeaderEnd - iHeaderStart);
+        if (end)
+        {
+            iHeaderStart = end + 1 - iHeaderBuffer;
+            if (iHeaderSkipping)
             {
-                c = HttpClient::read();
-                if (c != -1)
-                {
-                    switch(iState)
-                    {
-                    case eRequestSent:
-                        // We haven't reached the status code yet
-                        if ( (*statusPtr == '*') || (*statusPtr == c) )
-                        {
-                            // This character matches, just move along
-                            statusPtr++;
-                            if (*statusPtr == '\0')
-                            {
-                                // We've reached the end of the prefix
-                                iState = eReadingStatusCode;
-                            }
-                        }
-                        else
-                        {
-                            return HTTP_ERROR_INVALID_RESPONSE;
-                        }
-                        break;
-                    case eReadingStatusCode:
-                        if (isdigit(c))
-                        {
-                            // This assumes we won't get more than the 3 digits we
-                            // want
-                            iStatusCode = iStatusCode*10 + (c - '0');
-                        }
-                        else
-                        {
-                            // We've reached the end of the status code
-                            // We could sanity check it here or double-check for ' '
-                            // rather than anything else, but let's be lenient
-                            iState = eStatusCodeRead;
-                        }
-                        break;
-                    case eStatusCodeRead:
-                        // We're just waiting for the end of the line now
-                        break;
-
-                    default:
-                        break;
-                    };
-                    // We read something, reset the timeout counter
-                    timeoutStart = millis();
-                }
+                // The end of a line too long to keep, drop it
+                iHeaderSkipping = false;
+                continue;
             }
-            else
+            if ((end > start) && (end[-1] == '\r'))
             {
-                // We haven't got any data, so let's pause to allow some to
-                // arrive
-                delay(iHttpWaitForDataDelay);
+                end--;
             }
+            *end = '\0';
+            *aLine = start;
+            *aLength = end - start;
+            return HTTP_SUCCESS;
         }
-        if ( (c == '\n') && (iStatusCode < 200 && iStatusCode != 101) )
+
+        // No whole line yet, move what there is of it to the front to make
+        // room for the rest
+        memmove(iHeaderBuffer, start, iHeaderEnd - iHeaderStart);
+        iHeaderEnd -= iHeaderStart;
+        iHeaderStart = 0;
+        if (iHeaderEnd == kHeaderBufferSize)
         {
-            // We've reached the end of an informational status line
-            c = '\0'; // Clear c so we'll go back into the data reading loop
+            iHeaderSkipping = true;
+            iHeaderEnd = 0;
         }
+
+        int avail = iClient->available();
+        if (avail <= 0)
+        {
+            return HTTP_PENDING;
+        }
+        size_t space = kHeaderBufferSize - iHeaderEnd;
+        int count = iClient->read((uint8_t*)iHeaderBuffer + iHeaderEnd, ((size_t)avail < space) ? (size_t)avail : space);
+        if (count <= 0)
+        {
+            return HTTP_PENDING;
+        }
+        iHeaderEnd += count;
+        // We read something, reset the timeout counter
+        iLastProgress = millis();
+    }
+}
+
+int HttpClient::scanHeader(char** aLine, size_t* aLength)
+{
+    int ret = scanLine(aLine, aLength);
+    if (ret != HTTP_SUCCESS)
+    {
+        return ret;
     }
-    // If we've read a status code successfully but it's informational (1xx)
-    // loop back to the start
-    while ( (iState == eStatusCodeRead) && (iStatusCode < 200 && iStatusCode != 101) );
 
-    if ( (c == '\n') && (iState == eStatusCodeRead) )
+    if (*aLength > 0)
+    {
+        processHeader(*aLine, *aLength);
+    }
+    else if ((iStatusCode == 204) || (iStatusCode == 304))
     {
-        // We've read the status-line successfully
-        return iStatusCode;
+        // A blank line, that's the end of the headers.  These responses
+        // never have a body, whatever the headers say
+        iContentLength = 0;
+        iBodyLengthConsumed = 0;
+        iIsChunked = false;
+        iState = eReadingBody;
     }
-    else if (c != '\n')
+    else if (iIsChunked)
     {
-        // We must've timed out before we reached the end of the line
-        return HTTP_ERROR_TIMED_OUT;
+        iState = eReadingChunkLength;
+        iChunkLength = 0;
+        iChunkLengthDigits = false;
     }
     else
     {
-        // This wasn't a properly formed status line, or at least not one we
-        // could understand
-        return HTTP_ERROR_INVALID_RESPONSE;
+        iState = eReadingBody;
     }
+    return HTTP_SUCCESS;
 }
 
-int HttpClient::skipResponseHeaders()
+// Compare a header name, which isn't NUL terminated, ignoring case
+static bool headerNameIs(const char* aName, size_t aLength, const char* aWanted)
 {
-    // Just keep reading until we finish reading the headers or time out
-    unsigned long timeoutStart = millis();
-    // Whilst we haven't timed out & haven't reached the end of the headers
-    while ((!endOfHeadersReached()) && 
-           ( (millis() - timeoutStart) < iHttpResponseTimeout ))
+    return (strlen(aWanted) == aLength) && (strncasecmp(aName, aWanted, aLength) == 0);
+}
+
+void HttpClient::processHeader(char* aLine, size_t aLength)
+{
+    char* colon = (char*)memchr(aLine, ':', aLength);
+    if (!colon)
+    {
+        return;
+    }
+    size_t nameLength = colon - aLine;
+
+    // trim any whitespace around the value
+    char* value = colon + 1;
+    char* end = aLine + aLength;
+    while ((value < end) && isSpace(*value))
+    {
+        value++;
+    }
+    while ((end > value) && isSpace(end[-1]))
     {
-        if (available())
+        end--;
+    }
+    size_t valueLength = end - value;
+
+    if (headerNameIs(aLine, nameLength, HTTP_HEADER_CONTENT_LENGTH))
+    {
+        // Just in case we get multiple Content-Length headers, this
+        // will ensure we just get the value of the last one
+        iContentLength = 0;
+        iBodyLengthConsumed = 0;
+        for (char* digit = value; (digit < end) && isdigit(*digit); digit++)
         {
-            (void)readHeader();
-            // We read something, reset the timeout counter
-            timeoutStart = millis();
+            iContentLength = iContentLength*10 + (*digit - '0');
         }
-        else
+    }
+    else if (headerNameIs(aLine, nameLength, HTTP_HEADER_TRANSFER_ENCODING))
+    {
+        // chunked is always the last of the encodings applied
+        size_t chunkedLength = strlen(HTTP_HEADER_VALUE_CHUNKED);
+        iIsChunked = (valueLength >= chunkedLength) &&
+                     (strncasecmp(end - chunkedLength, HTTP_HEADER_VALUE_CHUNKED, chunkedLength) == 0);
+    }
+
+    for (size_t idx = 0; idx < iWatchedCount; idx++)
+    {
+        HttpHeader& header = iWatchedHeaders[idx];
+        if (headerNameIs(aLine, nameLength, header.name) &&
+            (valueLength <= kHeaderValuesSize - iHeaderValuesLength))
         {
-            // We haven't got any data, so let's pause to allow some to
-            // arrive
-            delay(iHttpWaitForDataDelay);
+            header.value = iHeaderValues + iHeaderValuesLength;
+            header.length = valueLength;
+            memcpy(iHeaderValues + iHeaderValuesLength, value, valueLength);
+            iHeaderValuesLength += valueLength;
         }
     }
-    if (endOfHeadersReached())
+}
+
+void HttpClient::watchHeaders(HttpHeader* aHeaders, size_t aCount)
+{
+    iWatchedHeaders = aHeaders;
+    iWatchedCount = aCount;
+    for (size_t idx = 0; idx < aCount; idx++)
     {
-        // Success
-        return HTTP_SUCCESS;
+        aHeaders[idx].value = NULL;
+        aHeaders[idx].length = 0;
     }
-    else
+}
+
+int HttpClient::pollResponse(uint8_t* aBuffer, size_t aSize, int* aLength)
+{
+    *aLength = iBodyStored;
+
+    int status = pollStatusCode();
+    if (status == HTTP_PENDING)
+    {
+        return responseTimedOut() ? HTTP_ERROR_TIMED_OUT : HTTP_PENDING;
+    }
+    if (status < 0)
+    {
+        return status;
+    }
+
+    int ret = pollBody(aBuffer, aSize);
+    *aLength = iBodyStored;
+    if (ret == HTTP_PENDING)
     {
-        // We must've timed out
-        return HTTP_ERROR_TIMED_OUT;
+        return responseTimedOut() ? HTTP_ERROR_TIMED_OUT : HTTP_PENDING;
     }
+    return (ret == HTTP_SUCCESS) ? status : ret;
+}
+
+bool HttpClient::responseTimedOut()
+{
+    return (millis() - iLastProgress) >= iHttpResponseTimeout;
+}
+
+void HttpClient::startResponse()
+{
+    iStatusCode = 0;
+    iBodyStored = 0;
+    iHeaderValuesLength = 0;
+    for (size_t idx = 0; idx < iWatchedCount; idx++)
+    {
+        iWatchedHeaders[idx].value = NULL;
+        iWatchedHeaders[idx].length = 0;
+    }
+    iLastProgress = millis();
+    iState = eRequestSent;
 }
 
 bool HttpClient::endOfHeadersReached()
 {
-    return (iState == eReadingBody || iState == eReadingChunkLength || iState == eReadingBodyChunk);
+    return (iState == eReadingBody || iState == eReadingChunkLength || iState == eReadingBodyChunk ||
+            iState == eLastChunkRead);
 };
 
 long HttpClient::contentLength()
@@ -595,8 +831,74 @@ String HttpClient::responseBody()
     return response;
 }
 
+int HttpClient::responseBody(uint8_t* aBuffer, size_t aSize)
+{
+    iBodyStored = 0;
+    iLastProgress = millis();
+    int ret;
+    while ((ret = pollBody(aBuffer, aSize)) == HTTP_PENDING)
+    {
+        if (responseTimedOut())
+        {
+            return HTTP_ERROR_TIMED_OUT;
+        }
+        // We haven't got any data, so let's pause to allow some to arrive
+        delay(iHttpWaitForDataDelay);
+    }
+    return (ret == HTTP_SUCCESS) ? (int)iBodyStored : ret;
+}
+
+int HttpClient::pollBody(uint8_t* aBuffer, size_t aSize)
+{
+    int ret = pollHeaders();
+    if (ret != HTTP_SUCCESS)
+    {
+        return ret;
+    }
+
+    size_t wanted = aSize;
+    if ((iContentLength != kNoContentLengthHeader) && ((size_t)iContentLength < wanted))
+    {
+        wanted = iContentLength;
+    }
+
+    while ((iBodyStored < wanted) && !endOfBodyReached())
+    {
+        int avail = available();
+        if (avail <= 0)
+        {
+            break;
+        }
+        int count = read(aBuffer + iBodyStored, min((size_t)avail, wanted - iBodyStored));
+        if (count <= 0)
+        {
+            break;
+        }
+        iBodyStored += count;
+        // We read something, reset the timeout counter
+        iLastProgress = millis();
+    }
+
+    if ((iBodyStored >= wanted) || endOfBodyReached())
+    {
+        return HTTP_SUCCESS;
+    }
+    if (!clientAvailable() && !iClient->connected())
+    {
+        // Server has finished sending, which is only the end of the body if
+        // there was no Content-Length saying otherwise
+        return (iContentLength == kNoContentLengthHeader) ? HTTP_SUCCESS : HTTP_ERROR_INVALID_RESPONSE;
+    }
+    return HTTP_PENDING;
+}
+
 bool HttpClient::endOfBodyReached()
 {
+    if (iState == eLastChunkRead)
+    {
+        // The zero length chunk that ends a chunked body has been read
+        return true;
+    }
     if (endOfHeadersReached() && (contentLength() != kNoContentLengthHeader))
     {
         // We've got to the body and we know how long it will be
@@ -609,13 +911,21 @@ int HttpClient::available()
 {
     if (iState == eReadingChunkLength)
     {
-        while (iClient->available())
+        while (clientAvailable())
         {
-            char c = iClient->read();
+            char c = clientRead();
 
             if (c == '\n')
             {
-                iState = eReadingBodyChunk;
+                if (!iChunkLengthDigits)
+                {
+                    // Just the line ending after the previous chunk's data
+                    continue;
+                }
+
+                // A zero length chunk marks the end of the body
+                iState = (iChunkLength == 0) ? eLastChunkRead : eReadingBodyChunk;
+                iChunkLengthDigits = false;
                 break;
             }
             else if (c == '\r')
@@ -624,9 +934,10 @@ int HttpClient::available()
             }
             else if (isHexadecimalDigit(c))
             {
-                char digit[2] = {c, '\0'};
+                int digit = (c <= '9') ? (c - '0') : ((c | 0x20) - 'a' + 10);
 
-                iChunkLength = (iChunkLength * 16) + strtol(digit, NULL, 16);
+                iChunkLength = (iChunkLength * 16) + digit;
+                iChunkLengthDigits = true;
             }
         }
     }
@@ -636,20 +947,20 @@ int HttpClient::available()
         iState = eReadingChunkLength;
     }
     
-    if (iState == eReadingChunkLength)
+    if (iState == eReadingChunkLength || iState == eLastChunkRead)
     {
         return 0;
     }
     
-    int clientAvailable = iClient->available();
+    int avail = clientAvailable();
 
     if (iState == eReadingBodyChunk)
     {
-        return min(clientAvailable, iChunkLength);
+        return min(avail, iChunkLength);
     }
     else
     {
-        return clientAvailable;
+        return avail;
     }
 }
 
@@ -661,13 +972,13 @@ int HttpClient::read()
         return -1;
     }
 
-    int ret = iClient->read();
+    int ret = clientRead();
     if (ret >= 0)
     {
-        if (endOfHeadersReached() && iContentLength > 0)
+        if (endOfHeadersReached())
         {
-            // We're outputting the body now and we've seen a Content-Length header
-            // So keep track of how many bytes are left
+            // We're outputting the body now, keep track of how much of it
+            // has been consumed
             iBodyLengthConsumed++;
         }
 
@@ -687,176 +998,182 @@ int HttpClient::read()
 bool HttpClient::headerAvailable()
 {
     // clear the currently stored header line
-    iHeaderLine = "";
+    iHeaderLine = NULL;
+    iHeaderLineLength = 0;
+    iLastProgress = millis();
 
     while (!endOfHeadersReached())
     {
-        // read a byte from the header
-        int c = readHeader();
-
-        if (c == '\r' || c == '\n')
+        char* line;
+        size_t length;
+        if (scanHeader(&line, &length) == HTTP_SUCCESS)
         {
-            if (iHeaderLine.length())
+            if (length > 0)
             {
-                // end of the line, all done
-                break;
-            } 
-            else
-            {
-                // ignore any CR or LF characters
-                continue;
+                iHeaderLine = line;
+                iHeaderLineLength = length;
+                // readHeader() has nothing of it left to hand out
+                iHeaderLinePos = length + 2;
             }
+            break;
         }
-
-        // append byte to header line
-        iHeaderLine += (char)c;
+        if (!iClient->connected() || responseTimedOut())
+        {
+            break;
+        }
+        // We haven't got any data, so let's pause to allow some to arrive
+        delay(iHttpWaitForDataDelay);
     }
 
-    return (iHeaderLine.length() > 0);
+    return (iHeaderLineLength > 0);
 }
 
 String HttpClient::readHeaderName()
 {
-    int colonIndex = iHeaderLine.indexOf(':');
+    const char* colon = iHeaderLine ? (const char*)memchr(iHeaderLine, ':', iHeaderLineLength) : NULL;
 
-    if (colonIndex == -1)
+    if (!colon)
     {
         return "";
     }
 
-    return iHeaderLine.substring(0, colonIndex);
+    String name;
+    name.reserve(colon - iHeaderLine);
+    for (const char* c = iHeaderLine; c < colon; c++)
+    {
+        name += *c;
+    }
+    return name;
 }
 
 String HttpClient::readHeaderValue()
 {
-    int colonIndex = iHeaderLine.indexOf(':');
-    int startIndex = colonIndex + 1;
+    const char* colon = iHeaderLine ? (const char*)memchr(iHeaderLine, ':', iHeaderLineLength) : NULL;
 
-    if (colonIndex == -1)
+    if (!colon)
     {
         return "";
     }
 
-    // trim any leading whitespace
-    while (startIndex < (int)iHeaderLine.length() && isSpace(iHeaderLine[startIndex]))
+    // trim any leading whitespace, the line is NUL terminated
+    const char* value = colon + 1;
+    while (isSpace(*value))
     {
-        startIndex++;
+        value++;
     }
 
-    return iHeaderLine.substring(startIndex);
+    return String(value);
 }
 
 int HttpClient::read(uint8_t *buf, size_t size)
 {
-    int ret =iClient->read(buf, size);
-    if (endOfHeadersReached() && iContentLength > 0)
+    if (!iIsChunked || !endOfHeadersReached())
     {
-        // We're outputting the body now and we've seen a Content-Length header
-        // So keep track of how many bytes are left
-        if (ret >= 0)
+        int ret = clientRead(buf, size);
+        if (endOfHeadersReached() && ret > 0)
         {
+            // We're outputting the body now, keep track of how much of it
+            // has been consumed
             iBodyLengthConsumed += ret;
         }
+        return ret;
     }
-    return ret;
+
+    // Chunked body, copy whole spans out of each chunk that has arrived,
+    // only stepping through the chunk length lines a byte at a time
+    size_t total = 0;
+    while (total < size)
+    {
+        int avail = available();
+        if (avail <= 0)
+        {
+            break;
+        }
+
+        int ret = clientRead(buf + total, min((size_t)avail, size - total));
+        if (ret <= 0)
+        {
+            break;
+        }
+
+        total += ret;
+        iBodyLengthConsumed += ret;
+        iChunkLength -= ret;
+        if (iChunkLength == 0)
+        {
+            iState = eReadingChunkLength;
+        }
+    }
+
+    return (total > 0) ? (int)total : -1;
 }
 
 int HttpClient::readHeader()
 {
-    char c = HttpClient::read();
+    if (iHeaderLine && (iHeaderLinePos < iHeaderLineLength + 2))
+    {
+        // Hand out the current line, with the line ending it had
+        size_t pos = iHeaderLinePos++;
+        return (pos < iHeaderLineLength) ? iHeaderLine[pos] : ((pos == iHeaderLineLength) ? '\r' : '\n');
+    }
 
     if (endOfHeadersReached())
     {
         // We've passed the headers, but rather than return an error, we'll just
         // act as a slightly less efficient version of read()
-        return c;
+        return HttpClient::read();
     }
 
     // Whilst reading out the headers to whoever wants them, we'll keep an
-    // eye out for the "Content-Length" header
-    switch(iState)
+    // eye out for the Content-Length and any other interesting headers
+    char* line;
+    size_t length;
+    if (scanHeader(&line, &length) != HTTP_SUCCESS)
     {
-    case eStatusCodeRead:
-        // We're at the start of a line, or somewhere in the middle of reading
-        // the Content-Length prefix
-        if (*iContentLengthPtr == c)
-        {
-            // This character matches, just move along
-            iContentLengthPtr++;
-            if (*iContentLengthPtr == '\0')
-            {
-                // We've reached the end of the prefix
-                iState = eReadingContentLength;
-                // Just in case we get multiple Content-Length headers, this
-                // will ensure we just get the value of the last one
-                iContentLength = 0;
-                iBodyLengthConsumed = 0;
-            }
-        }
-        else if (*iTransferEncodingChunkedPtr == c)
-        {
-            // This character matches, just move along
-            iTransferEncodingChunkedPtr++;
-            if (*iTransferEncodingChunkedPtr == '\0')
-            {
-                // We've reached the end of the Transfer Encoding: chunked header
-                iIsChunked = true;
-                iState = eSkipToEndOfHeader;
-            }
-        }
-        else if (((iContentLengthPtr == kContentLengthPrefix) && (iTransferEncodingChunkedPtr == kTransferEncodingChunked)) && (c == '\r'))
-        {
-            // We've found a '\r' at the start of a line, so this is probably
-            // the end of the headers
-            iState = eLineStartingCRFound;
-        }
-        else
-        {
-            // This isn't the Content-Length or Transfer Encoding chunked header, skip to the end of the line
-            iState = eSkipToEndOfHeader;
-        }
-        break;
-    case eReadingContentLength:
-        if (isdigit(c))
-        {
-            iContentLength = iContentLength*10 + (c - '0');
-        }
-        else
-        {
-            // We've reached the end of the content length
-            // We could sanity check it here or double-check for "\r\n"
-            // rather than anything else, but let's be lenient
-            iState = eSkipToEndOfHeader;
-        }
-        break;
-    case eLineStartingCRFound:
-        if (c == '\n')
-        {
-            if (iIsChunked)
-            {
-                iState = eReadingChunkLength;
-                iChunkLength = 0;
-            }
-            else
-            {
-                iState = eReadingBody;
-            }
-        }
-        break;
-    default:
-        // We're just waiting for the end of the line now
-        break;
-    };
+        return -1;
+    }
+    iHeaderLine = line;
+    iHeaderLineLength = length;
+    iHeaderLinePos = 0;
+    return readHeader();
+}
 
-    if ( (c == '\n') && !endOfHeadersReached() )
+int HttpClient::peek()
+{
+    if (iHeaderStart < iHeaderEnd)
     {
-        // We've got to the end of this line, start processing again
-        iState = eStatusCodeRead;
-        iContentLengthPtr = kContentLengthPrefix;
-        iTransferEncodingChunkedPtr = kTransferEncodingChunked;
+        return (uint8_t)iHeaderBuffer[iHeaderStart];
     }
-    // And return the character read to whoever wants it
-    return c;
+    return iClient->peek();
+}
+
+int HttpClient::clientAvailable()
+{
+    return (iHeaderEnd - iHeaderStart) + iClient->available();
+}
+
+int HttpClient::clientRead()
+{
+    if (iHeaderStart < iHeaderEnd)
+    {
+        return (uint8_t)iHeaderBuffer[iHeaderStart++];
+    }
+    return iClient->read();
+}
+
+int HttpClient::clientRead(uint8_t* aBuffer, size_t aSize)
+{
+    size_t buffered = iHeaderEnd - iHeaderStart;
+    if (buffered == 0)
+    {
+        return iClient->read(aBuffer, aSize);
+    }
+
+    // Whatever came in along with the end of the headers goes first
+    size_t count = (buffered < aSize) ? buffered : aSize;
+    memcpy(aBuffer, iHeaderBuffer + iHeaderStart, count);
+    iHeaderStart += count;
+    return count;
 }
 
 
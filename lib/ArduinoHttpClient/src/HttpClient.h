@@ -22,6 +22,9 @@ static const int HTTP_ERROR_TIMED_OUT =-3;
 // The response from the server is invalid, is it definitely an HTTP
 // server?
 static const int HTTP_ERROR_INVALID_RESPONSE =-4;
+// The response is still arriving, call again once more of it may have come
+// in.  Never a valid status code so it can share a return value with them
+static const int HTTP_PENDING =1;
 
 // Define some of the common methods and headers here
 // That lets other code reuse them without having to declare another copy
@@ -38,6 +41,20 @@ static const int HTTP_ERROR_INVALID_RESPONSE =-4;
 #define HTTP_HEADER_USER_AGENT     "User-Agent"
 #define HTTP_HEADER_VALUE_CHUNKED  "chunked"
 
+/** A response header to capture while the headers are scanned.
+  Set name before passing an array of these to HttpClient::watchHeaders().
+  Once the headers have been read, value points at the trimmed value of the
+  last header of that name (not NUL terminated) and length is its size, or
+  value is NULL if the header wasn't in the response or didn't fit.  The
+  value is held by the HttpClient and stays valid until the next request.
+*/
+struct HttpHeader
+{
+    const char* name;
+    const char* value;
+    size_t length;
+};
+
 class HttpClient : public Client
 {
 public:
@@ -217,6 +234,15 @@ public:
     */
     int responseStatusCode();
 
+    /** Capture some response headers as they are scanned.
+      The headers are matched, without regard to case, against aHeaders on
+      every response until this is called again, whether they are read with
+      skipResponseHeaders(), pollResponse() or headerAvailable().
+      @param aHeaders Headers to look for, kept by reference
+      @param aCount Number of entries in aHeaders
+    */
+    void watchHeaders(HttpHeader* aHeaders, size_t aCount);
+
     /** Check if a header is available to be read.
       Use readHeaderName() to read header name, and readHeaderValue() to
       read the header value
@@ -260,7 +286,8 @@ public:
     bool endOfHeadersReached();
 
     /** Test whether the end of the body has been reached.
-      Only works if the Content-Length header was returned by the server
+      Only works if the Content-Length header was returned by the server, or
+      the body is chunked
       @return true if we are now at the end of the body, else false
     */
     bool endOfBodyReached();
@@ -287,6 +314,35 @@ public:
     */
     String responseBody();
 
+    /** Read the response body into a caller supplied buffer
+      Also skips response headers if they have not been read already
+      Whatever has arrived is copied across in blocks rather than a byte at a
+      time, and the response timeout applies to the body as a whole, so no
+      heap is used and a slow server costs one timeout rather than one per byte.
+      Reading stops once aSize bytes are stored, the rest of the body is left
+      unread.
+      MUST be called after responseStatusCode()
+      @param aBuffer Buffer to store the body in
+      @param aSize Size of aBuffer, in bytes
+      @return Number of bytes stored, or an HTTP_ERROR_* code if the headers or
+      the expected amount of the body did not arrive
+    */
+    int responseBody(uint8_t* aBuffer, size_t aSize);
+
+    /** Read as much of the response as has arrived, without waiting for more
+      This is the non-blocking form of responseStatusCode() followed by
+      responseBody(aBuffer, aSize).  Call it repeatedly after sending the
+      request, with the same buffer each time, and it parses whatever the
+      client has available and returns straight away.  The response timeout
+      applies from the last time any data arrived.
+      @param aBuffer Buffer to store the body in
+      @param aSize Size of aBuffer, in bytes
+      @param aLength Set to the number of body bytes stored so far
+      @return HTTP_PENDING until the body has been read, then the status code,
+      or an HTTP_ERROR_* code if the response failed
+    */
+    int pollResponse(uint8_t* aBuffer, size_t aSize, int* aLength);
+
     /** Enables connection keep-alive mode
     */
     void connectionKeepAlive();
@@ -306,15 +362,20 @@ public:
       @return Byte read or -1 if there are no bytes available.
     */
     virtual int read();
+    /** Read up to size bytes from the server.
+      Chunked bodies are decoded as they are read, copying whole spans out of
+      each chunk rather than going a byte at a time.
+      @return Number of bytes read or -1 if there are no bytes available.
+    */
     virtual int read(uint8_t *buf, size_t size);
-    virtual int peek() { return iClient->peek(); };
+    virtual int peek();
     virtual void flush() { iClient->flush(); };
 
     // Inherited from Client
     virtual int connect(IPAddress ip, uint16_t port) { return iClient->connect(ip, port); };
     virtual int connect(const char *host, uint16_t port) { return iClient->connect(host, port); };
     virtual void stop();
-    virtual uint8_t connected() { return iClient->connected(); };
+    virtual uint8_t connected() { return iClient->connected() || (iHeaderStart < iHeaderEnd); };
     virtual operator bool() { return bool(iClient); };
     virtual uint32_t httpResponseTimeout() { return iHttpResponseTimeout; };
     virtual void setHttpResponseTimeout(uint32_t timeout) { iHttpResponseTimeout = timeout; };
@@ -337,10 +398,70 @@ protected:
     */
     void finishHeaders();
 
+    /* Add the blank line ending the headers to the request without sending it
+    */
+    void endHeaders();
+
+    /** Add to the request being built up in iRequestBuffer.
+      Nothing is sent until flushRequest() unless the buffer fills, so the
+      request line and headers go out in as few writes, and packets, as
+      possible rather than one for every piece of every line.
+    */
+    void queueRequest(const char* aData, size_t aLength);
+    void queueRequest(const char* aText);
+    void queueRequest(long aValue);
+
+    /** Send whatever has been added to the request with a single write
+    */
+    void flushRequest();
+
     /** Reading any pending data from the client (used in connection keep alive mode)
     */
     void flushClientRx();
 
+    /** Get ready to read the response to the request just sent
+    */
+    void startResponse();
+
+    /** Parse as much of the status line, the headers or the body as has
+      arrived.  The blocking calls are these in a loop with a delay.
+      @return HTTP_PENDING if more is needed, else as the blocking call
+    */
+    int pollStatusCode();
+    int pollHeaders();
+    int pollBody(uint8_t* aBuffer, size_t aSize);
+
+    /** Find the next whole line of the response in iHeaderBuffer, reading
+      as much as the client has available into it in one go when there
+      isn't one yet.  Lines too long for the buffer are skipped.
+      @param aLine Set to the start of the line, which is NUL terminated in
+      place of its line ending
+      @param aLength Set to the length of the line, without its line ending
+      @return HTTP_SUCCESS, or HTTP_PENDING until a whole line has arrived
+    */
+    int scanLine(char** aLine, size_t* aLength);
+
+    /** Scan the next header line and act on it, or on the blank line that
+      ends the headers.  Parameters and return as scanLine()
+    */
+    int scanHeader(char** aLine, size_t* aLength);
+
+    /** Pick out the Content-Length and Transfer-Encoding headers, and any
+      being watched, from a header line
+    */
+    void processHeader(char* aLine, size_t aLength);
+
+    /** The client's available() and read() but taking any of the body that
+      was read into iHeaderBuffer along with the end of the headers first
+    */
+    int clientAvailable();
+    int clientRead();
+    int clientRead(uint8_t* aBuffer, size_t aSize);
+
+    /** Test whether nothing has arrived for the response timeout
+    */
+    bool responseTimedOut();
+
     // Number of milliseconds that we wait each time there isn't any data
     // available to be read (during status code and header processing)
     static const int kHttpWaitForDataDelay = 100;
@@ -348,20 +469,21 @@ protected:
     // data before returning HTTP_ERROR_TIMED_OUT (during status code and header
     // processing)
     static const int kHttpResponseTimeout = 30*1000;
-    static const char* kContentLengthPrefix;
-    static const char* kTransferEncodingChunked;
+    // Size of the buffer the request line and headers are gathered in
+    static const size_t kRequestBufferSize = 256;
+    // Size of the buffer response lines are scanned in, longer lines are skipped
+    static const size_t kHeaderBufferSize = 128;
+    // Space for the values of the watched headers
+    static const size_t kHeaderValuesSize = 96;
     typedef enum {
         eIdle,
         eRequestStarted,
         eRequestSent,
-        eReadingStatusCode,
         eStatusCodeRead,
-        eReadingContentLength,
-        eSkipToEndOfHeader,
-        eLineStartingCRFound,
         eReadingBody,
         eReadingChunkLength,
-        eReadingBodyChunk
+        eReadingBodyChunk,
+        eLastChunkRead
     } tHttpState;
     // Client we're using
     Client* iClient;
@@ -374,23 +496,44 @@ protected:
     tHttpState iState;
     // Stores the status code for the response, once known
     int iStatusCode;
+    // When data last arrived, for the response timeout
+    unsigned long iLastProgress;
+    // How many bytes of the response body have been stored by pollBody()
+    size_t iBodyStored;
     // Stores the value of the Content-Length header, if present
     long iContentLength;
     // How many bytes of the response body have been read by the user
     int iBodyLengthConsumed;
-    // How far through a Content-Length header prefix we are
-    const char* iContentLengthPtr;
-    // How far through a Transfer-Encoding chunked header we are
-    const char* iTransferEncodingChunkedPtr;
     // Stores if the response body is chunked
     bool iIsChunked;
     // Stores the value of the current chunk length, if present
     int iChunkLength;
+    // Whether any digits of the current chunk length have been read yet
+    bool iChunkLengthDigits;
     uint32_t iHttpResponseTimeout;
     uint32_t iHttpWaitForDataDelay;
     bool iConnectionClose;
     bool iSendDefaultRequestHeaders;
-    String iHeaderLine;
+    // Response lines being scanned, unread data runs from iHeaderStart to
+    // iHeaderEnd and once the headers are done is the start of the body
+    char iHeaderBuffer[kHeaderBufferSize];
+    size_t iHeaderStart;
+    size_t iHeaderEnd;
+    // Whether the rest of a line too long for iHeaderBuffer is being dropped
+    bool iHeaderSkipping;
+    // Current header line for readHeaderName(), readHeaderValue() and
+    // readHeader(), and how much of it readHeader() has handed out
+    const char* iHeaderLine;
+    size_t iHeaderLineLength;
+    size_t iHeaderLinePos;
+    // Headers to capture and where their values are kept
+    HttpHeader* iWatchedHeaders;
+    size_t iWatchedCount;
+    char iHeaderValues[kHeaderValuesSize];
+    size_t iHeaderValuesLength;
+    // Request line and headers not yet sent
+    char iRequestBuffer[kRequestBufferSize];
+    size_t iRequestLength;
 };
 
 #endif
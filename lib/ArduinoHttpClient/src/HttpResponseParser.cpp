@@ -0,0 +1,377 @@
+// Incremental HTTP response parser working in place on the caller's buffers
+// Released under Apache License, version 2.0
+
+#include "HttpResponseParser.h"
+
+// Compare a header name, which isn't NUL terminated, ignoring case
+static bool nameIs(const char* aName, size_t aLength, const char* aWanted)
+{
+    return (strlen(aWanted) == aLength) && (strncasecmp(aName, aWanted, aLength) == 0);
+}
+
+// Look for a word in a header value, ignoring case
+static bool valueHas(const char* aValue, size_t aLength, const char* aWanted)
+{
+    size_t wantedLength = strlen(aWanted);
+    for (size_t idx = 0; idx + wantedLength <= aLength; idx++)
+    {
+        if (strncasecmp(aValue + idx, aWanted, wantedLength) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+HttpResponseParser::HttpResponseParser(const HttpResponseCallbacks& aCallbacks, void* aContext)
+ : iCallbacks(aCallbacks), iContext(aContext)
+{
+    reset();
+}
+
+void HttpResponseParser::reset()
+{
+    iState = eStatusLine;
+    iStatusCode = 0;
+    iInterim = false;
+    iContentLength = HttpClient::kNoContentLengthHeader;
+    iIsChunked = false;
+    iKeepAlive = false;
+    iRemaining = 0;
+    iLineLength = 0;
+    iLineSkipping = false;
+}
+
+size_t HttpResponseParser::execute(const uint8_t* aData, size_t aLength)
+{
+    const uint8_t* data = aData;
+    const uint8_t* end = aData + aLength;
+
+    while ((data < end) && (iState != eComplete) && (iState != eFailed))
+    {
+        if ((iState == eBody) || (iState == eChunkData))
+        {
+            size_t count = end - data;
+            if (count > iRemaining)
+            {
+                count = iRemaining;
+            }
+            body(data, count);
+            data += count;
+            iRemaining -= count;
+            if (iRemaining == 0)
+            {
+                if (iState == eBody)
+                {
+                    messageComplete();
+                }
+                else if (iState == eChunkData)
+                {
+                    iState = eChunkEnd;
+                }
+            }
+            continue;
+        }
+        if (iState == eBodyToClose)
+        {
+            body(data, end - data);
+            data = end;
+            continue;
+        }
+
+        // Everything else comes a line at a time
+        const uint8_t* newline = (const uint8_t*)memchr(data, '\n', end - data);
+        const uint8_t* stop = newline ? newline : end;
+        const char* line = (const char*)data;
+        size_t length = stop - data;
+
+        if ((iLineLength > 0) || iLineSkipping || !newline)
+        {
+            // The line isn't all here, gather it up until it is
+            if (!iLineSkipping && (length <= kLineSize - iLineLength))
+            {
+                memcpy(iLine + iLineLength, data, length);
+                iLineLength += length;
+            }
+            else
+            {
+                iLineSkipping = true;
+            }
+            line = iLine;
+            length = iLineLength;
+        }
+        if (!newline)
+        {
+            data = end;
+            break;
+        }
+        data = newline + 1;
+
+        bool skipped = iLineSkipping;
+        iLineLength = 0;
+        iLineSkipping = false;
+        if (skipped)
+        {
+            // Only a header can be safely dropped, anything else that long
+            // is nonsense
+            if ((iState != eHeaderLine) && (iState != eTrailer))
+            {
+                iState = eFailed;
+            }
+            continue;
+        }
+
+        if ((length > 0) && (line[length - 1] == '\r'))
+        {
+            length--;
+        }
+        processLine(line, length);
+    }
+
+    return data - aData;
+}
+
+bool HttpResponseParser::finish()
+{
+    if (iState == eBodyToClose)
+    {
+        messageComplete();
+    }
+    return (iState == eComplete);
+}
+
+int HttpResponseParser::poll(Client& aClient, uint8_t* aBuffer, size_t aSize)
+{
+    while (!complete() && !failed())
+    {
+        int avail = aClient.available();
+        if (avail <= 0)
+        {
+            if (aClient.connected())
+            {
+                return HTTP_PENDING;
+            }
+            // The server has finished sending
+            return finish() ? HTTP_SUCCESS : HTTP_ERROR_INVALID_RESPONSE;
+        }
+
+        int count = aClient.read(aBuffer, ((size_t)avail < aSize) ? (size_t)avail : aSize);
+        if (count <= 0)
+        {
+            return HTTP_PENDING;
+        }
+        execute(aBuffer, count);
+    }
+    return complete() ? HTTP_SUCCESS : HTTP_ERROR_INVALID_RESPONSE;
+}
+
+void HttpResponseParser::processLine(const char* aLine, size_t aLength)
+{
+    switch (iState)
+    {
+    case eStatusLine:
+        processStatus(aLine, aLength);
+        break;
+    case eHeaderLine:
+        if (aLength == 0)
+        {
+            headersComplete();
+        }
+        else
+        {
+            processHeader(aLine, aLength);
+        }
+        break;
+    case eChunkSize:
+        processChunkSize(aLine, aLength);
+        break;
+    case eChunkEnd:
+        // Just the line ending after the chunk's data
+        iState = (aLength == 0) ? eChunkSize : eFailed;
+        break;
+    case eTrailer:
+        // Trailers aren't passed on, just look for the blank line after them
+        if (aLength == 0)
+        {
+            messageComplete();
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void HttpResponseParser::processStatus(const char* aLine, size_t aLength)
+{
+    if (aLength == 0)
+    {
+        // The blank line ending an interim response
+        return;
+    }
+
+    // Status-Line = HTTP-Version SP Status-Code SP Reason-Phrase CRLF
+    if ((aLength < 9) || (strncmp(aLine, "HTTP/", 5) != 0) || (aLine[6] != '.') || (aLine[8] != ' '))
+    {
+        iState = eFailed;
+        return;
+    }
+
+    iStatusCode = 0;
+    for (size_t idx = 9; (idx < aLength) && isdigit(aLine[idx]); idx++)
+    {
+        iStatusCode = iStatusCode*10 + (aLine[idx] - '0');
+    }
+    iInterim = (iStatusCode < 200) && (iStatusCode != 101);
+    // HTTP/1.1 connections are kept alive unless the server says otherwise
+    iKeepAlive = (aLine[7] != '0');
+    iState = eHeaderLine;
+
+    if (!iInterim && iCallbacks.onStatus && iCallbacks.onStatus(iContext, iStatusCode))
+    {
+        iState = eFailed;
+    }
+}
+
+void HttpResponseParser::processHeader(const char* aLine, size_t aLength)
+{
+    const char* colon = (const char*)memchr(aLine, ':', aLength);
+    if (!colon || iInterim)
+    {
+        return;
+    }
+    size_t nameLength = colon - aLine;
+
+    // trim any whitespace around the value
+    const char* value = colon + 1;
+    const char* end = aLine + aLength;
+    while ((value < end) && isSpace(*value))
+    {
+        value++;
+    }
+    while ((end > value) && isSpace(end[-1]))
+    {
+        end--;
+    }
+    size_t valueLength = end - value;
+
+    if (nameIs(aLine, nameLength, HTTP_HEADER_CONTENT_LENGTH))
+    {
+        iContentLength = 0;
+        for (const char* digit = value; digit < end; digit++)
+        {
+            if (!isdigit(*digit))
+            {
+                iState = eFailed;
+                return;
+            }
+            iContentLength = iContentLength*10 + (*digit - '0');
+        }
+    }
+    else if (nameIs(aLine, nameLength, HTTP_HEADER_TRANSFER_ENCODING))
+    {
+        // chunked is always the last of the encodings applied
+        size_t chunkedLength = strlen(HTTP_HEADER_VALUE_CHUNKED);
+        iIsChunked = (valueLength >= chunkedLength) &&
+                     (strncasecmp(end - chunkedLength, HTTP_HEADER_VALUE_CHUNKED, chunkedLength) == 0);
+    }
+    else if (nameIs(aLine, nameLength, HTTP_HEADER_CONNECTION))
+    {
+        if (valueHas(value, valueLength, "close"))
+        {
+            iKeepAlive = false;
+        }
+        else if (valueHas(value, valueLength, "keep-alive"))
+        {
+            iKeepAlive = true;
+        }
+    }
+
+    if (iCallbacks.onHeader && iCallbacks.onHeader(iContext, aLine, nameLength, value, valueLength))
+    {
+        iState = eFailed;
+    }
+}
+
+void HttpResponseParser::processChunkSize(const char* aLine, size_t aLength)
+{
+    // chunk-size [ chunk-extension ] CRLF, the extensions are ignored
+    size_t idx = 0;
+    iRemaining = 0;
+    for (; (idx < aLength) && isHexadecimalDigit(aLine[idx]); idx++)
+    {
+        char c = aLine[idx];
+        iRemaining = iRemaining*16 + ((c <= '9') ? (c - '0') : ((c | 0x20) - 'a' + 10));
+    }
+
+    if (idx == 0)
+    {
+        iState = eFailed;
+    }
+    else
+    {
+        // A zero length chunk marks the end of the body
+        iState = (iRemaining == 0) ? eTrailer : eChunkData;
+    }
+}
+
+void HttpResponseParser::headersComplete()
+{
+    if (iInterim)
+    {
+        // Start over with the real response
+        iState = eStatusLine;
+        iInterim = false;
+        iContentLength = HttpClient::kNoContentLengthHeader;
+        iIsChunked = false;
+        return;
+    }
+
+    if (iCallbacks.onHeadersComplete && iCallbacks.onHeadersComplete(iContext))
+    {
+        iState = eFailed;
+        return;
+    }
+
+    if ((iStatusCode == 101) || (iStatusCode == 204) || (iStatusCode == 304))
+    {
+        // These never have a body, whatever the headers say.  After a 101
+        // the connection carries on in another protocol
+        messageComplete();
+    }
+    else if (iIsChunked)
+    {
+        iState = eChunkSize;
+    }
+    else if (iContentLength == 0)
+    {
+        messageComplete();
+    }
+    else if (iContentLength > 0)
+    {
+        iRemaining = iContentLength;
+        iState = eBody;
+    }
+    else
+    {
+        // The body runs until the server closes the connection
+        iKeepAlive = false;
+        iState = eBodyToClose;
+    }
+}
+
+void HttpResponseParser::body(const uint8_t* aData, size_t aLength)
+{
+    if (iCallbacks.onBody && iCallbacks.onBody(iContext, aData, aLength))
+    {
+        iState = eFailed;
+    }
+}
+
+void HttpResponseParser::messageComplete()
+{
+    iState = eComplete;
+    if (iCallbacks.onMessageComplete && iCallbacks.onMessageComplete(iContext))
+    {
+        iState = eFailed;
+    }
+}
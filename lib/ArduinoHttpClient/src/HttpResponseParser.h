@@ -0,0 +1,140 @@
+// Incremental HTTP response parser working in place on the caller's buffers
+// Released under Apache License, version 2.0
+
+#ifndef HttpResponseParser_h
+#define HttpResponseParser_h
+
+#include <Arduino.h>
+#include "Client.h"
+#include "HttpClient.h"
+
+/** Callbacks made by HttpResponseParser as it works through a response.
+  These follow the callbacks of http_parser, except that each header is
+  passed whole rather than in pieces.  Any of them may be NULL.  Names,
+  values and body data point straight into the buffer given to execute(),
+  or for a header line split across two buffers into the parser, so they
+  are only valid for the duration of the call.  Return 0 to carry on, or
+  anything else to abandon the response.
+*/
+struct HttpResponseCallbacks
+{
+    int (*onStatus)(void* aContext, int aStatusCode);
+    int (*onHeader)(void* aContext, const char* aName, size_t aNameLength,
+                    const char* aValue, size_t aValueLength);
+    int (*onHeadersComplete)(void* aContext);
+    int (*onBody)(void* aContext, const uint8_t* aData, size_t aLength);
+    int (*onMessageComplete)(void* aContext);
+};
+
+class HttpResponseParser
+{
+public:
+    /** Create a parser ready for its first response.
+      @param aCallbacks Callbacks to make, kept by reference
+      @param aContext Passed as the first parameter of every callback
+    */
+    HttpResponseParser(const HttpResponseCallbacks& aCallbacks, void* aContext = NULL);
+
+    /** Get ready for the next response
+    */
+    void reset();
+
+    /** Parse the next part of the response.
+      Interim (1xx) responses are skipped, other than 101 Switching Protocols.
+      Chunked bodies are decoded, each run of body data in aData going to
+      onBody without being copied.
+      @param aData Data received
+      @param aLength Number of bytes in aData
+      @return Number of bytes parsed, which is short of aLength only if the
+      response ended part way through aData or it was abandoned.
+    */
+    size_t execute(const uint8_t* aData, size_t aLength);
+
+    /** Tell the parser the server has closed the connection, which ends a
+      body with no length given.
+      @return true if the whole response has been parsed
+    */
+    bool finish();
+
+    /** Read whatever the client has available into aBuffer and parse it,
+      without waiting for more.  Call it again until it stops returning
+      HTTP_PENDING.  Anything that arrives after the end of the response is
+      dropped.
+      @param aClient Client the response is arriving on
+      @param aBuffer Buffer to read into, the size of a packet or so
+      @param aSize Size of aBuffer, in bytes
+      @return HTTP_PENDING until the response is complete, then HTTP_SUCCESS,
+      or HTTP_ERROR_INVALID_RESPONSE if it was malformed, abandoned or cut off
+    */
+    int poll(Client& aClient, uint8_t* aBuffer, size_t aSize);
+
+    /** Status code of the response, or 0 if its status line hasn't been parsed
+    */
+    int statusCode() { return iStatusCode; };
+
+    /** Value of the Content-Length header, or
+      HttpClient::kNoContentLengthHeader if there wasn't one
+    */
+    long contentLength() { return iContentLength; };
+
+    /** Whether the connection can be used again once the response is complete
+    */
+    bool keepAlive() { return iKeepAlive; };
+
+    bool complete() { return iState == eComplete; };
+    bool failed() { return iState == eFailed; };
+
+protected:
+    /** Act on a whole line of the status line, headers, chunk sizes or
+      trailers, without its line ending
+    */
+    void processLine(const char* aLine, size_t aLength);
+    void processStatus(const char* aLine, size_t aLength);
+    void processHeader(const char* aLine, size_t aLength);
+    void processChunkSize(const char* aLine, size_t aLength);
+
+    /** Work out how the body is delimited once the headers have all arrived
+    */
+    void headersComplete();
+
+    /** Pass some of the body on
+    */
+    void body(const uint8_t* aData, size_t aLength);
+
+    void messageComplete();
+
+    // Longest header line kept when split across two calls to execute(),
+    // longer split lines are skipped
+    static const size_t kLineSize = 128;
+    typedef enum {
+        eStatusLine,
+        eHeaderLine,
+        eBody,
+        eBodyToClose,
+        eChunkSize,
+        eChunkData,
+        eChunkEnd,
+        eTrailer,
+        eComplete,
+        eFailed
+    } tParserState;
+    const HttpResponseCallbacks& iCallbacks;
+    void* iContext;
+    // Current state of the finite-state-machine
+    tParserState iState;
+    int iStatusCode;
+    // Whether the response is an interim (1xx) one, which is skipped
+    bool iInterim;
+    long iContentLength;
+    bool iIsChunked;
+    bool iKeepAlive;
+    // Bytes left of the body, or of the current chunk
+    unsigned long iRemaining;
+    // The start of a line that wasn't all in one call to execute()
+    char iLine[kLineSize];
+    size_t iLineLength;
+    // Whether the line being gathered in iLine is too long to keep
+    bool iLineSkipping;
+};
+
+#endif
@@ -5,24 +5,92 @@
 
 #include "WebSocketClient.h"
 
+/* XOR aSize bytes of aBuffer with the mask key, starting aIndex bytes into
+   the key.  Bytes are handled singly only up to the first word boundary and
+   after the last one, in between a copy of the key rotated to line up with
+   the boundary is applied 32 bits at a time, each word copied through a
+   local so the buffer is never accessed through a uint32_t pointer.
+   @return Key index following the last byte masked
+*/
+static int applyMask(uint8_t* aBuffer, size_t aSize, const uint8_t aKey[4], int aIndex)
+{
+    size_t i = 0;
+
+    while ((i < aSize) && ((uintptr_t)(aBuffer + i) & 3))
+    {
+        aBuffer[i++] ^= aKey[aIndex++ & 3];
+    }
+
+    if ((aSize - i) >= 4)
+    {
+        uint8_t rotated[4];
+        uint32_t mask;
+
+        for (int k = 0; k < 4; k++)
+        {
+            rotated[k] = aKey[(aIndex + k) & 3];
+        }
+        memcpy(&mask, rotated, sizeof(mask));
+
+        // Whole words leave the key index where it was
+        uint8_t* words = (uint8_t*)__builtin_assume_aligned(aBuffer + i, 4);
+        size_t count = (aSize - i) / 4;
+        for (size_t w = 0; w < count; w++)
+        {
+            uint32_t word;
+            memcpy(&word, words + (w * 4), sizeof(word));
+            word ^= mask;
+            memcpy(words + (w * 4), &word, sizeof(word));
+        }
+        i += count * 4;
+    }
+
+    while (i < aSize)
+    {
+        aBuffer[i++] ^= aKey[aIndex++ & 3];
+    }
+
+    return aIndex & 3;
+}
+
+/* Size of the frame header starting with the aReceived bytes of aHeader,
+   only the opcode and length until those two have arrived.
+*/
+static int headerSize(const uint8_t* aHeader, int aReceived)
+{
+    if (aReceived < 2)
+    {
+        return 2;
+    }
+
+    int length = aHeader[1] & 0x7f;
+    int lengthBytes = (length == 126) ? 2 : ((length == 127) ? 8 : 0);
+    int maskBytes = (aHeader[1] & 0x80) ? 4 : 0;
+
+    return 2 + lengthBytes + maskBytes;
+}
+
 WebSocketClient::WebSocketClient(Client& aClient, const char* aServerName, uint16_t aServerPort)
  : HttpClient(aClient, aServerName, aServerPort),
    iTxStarted(false),
-   iRxSize(0)
+   iRxSize(0),
+   iRxHeaderSize(0)
 {
 }
 
 WebSocketClient::WebSocketClient(Client& aClient, const String& aServerName, uint16_t aServerPort) 
  : HttpClient(aClient, aServerName, aServerPort),
    iTxStarted(false),
-   iRxSize(0)
+   iRxSize(0),
+   iRxHeaderSize(0)
 {
 }
 
 WebSocketClient::WebSocketClient(Client& aClient, const IPAddress& aServerAddress, uint16_t aServerPort)
  : HttpClient(aClient, aServerAddress, aServerPort),
    iTxStarted(false),
-   iRxSize(0)
+   iRxSize(0),
+   iRxHeaderSize(0)
 {
 }
 
@@ -62,6 +130,7 @@ int WebSocketClient::begin(const char* aPath)
     }
 
     iRxSize = 0;
+    iRxHeaderSize = 0;
 
     // status code of 101 means success
     return (status == 101) ? 0 : status;
@@ -95,54 +164,51 @@ int WebSocketClient::endMessage()
         return 1;
     }
 
+    uint8_t header[kMaxHeaderSize];
+    size_t headerSize = 0;
+
     // send FIN + the message type (opcode)
-    HttpClient::write(0x80 | iTxMessageType);
+    header[headerSize++] = 0x80 | iTxMessageType;
 
     // the message is masked (0x80)
     // send the length
     if (iTxSize < 126)
     {
-        HttpClient::write(0x80 | (uint8_t)iTxSize);
-    }
-    else if (iTxSize < 0xffff)
-    {
-        HttpClient::write(0x80 | 126);
-        HttpClient::write((iTxSize >> 8) & 0xff);
-        HttpClient::write((iTxSize >> 0) & 0xff);
+        header[headerSize++] = 0x80 | (uint8_t)iTxSize;
     }
     else
     {
-        HttpClient::write(0x80 | 127);
-        HttpClient::write((iTxSize >> 56) & 0xff);
-        HttpClient::write((iTxSize >> 48) & 0xff);
-        HttpClient::write((iTxSize >> 40) & 0xff);
-        HttpClient::write((iTxSize >> 32) & 0xff);
-        HttpClient::write((iTxSize >> 24) & 0xff);
-        HttpClient::write((iTxSize >> 16) & 0xff);
-        HttpClient::write((iTxSize >> 8) & 0xff);
-        HttpClient::write((iTxSize >> 0) & 0xff);
-    }
+        int lengthBytes = (iTxSize <= 0xffff) ? 2 : 8;
 
-    uint8_t maskKey[4];
+        header[headerSize++] = 0x80 | ((lengthBytes == 2) ? 126 : 127);
+        for (int i = lengthBytes - 1; i >= 0; i--)
+        {
+            header[headerSize++] = (iTxSize >> (i * 8)) & 0xff;
+        }
+    }
 
-    // create a random mask for the data and send
-    for (int i = 0; i < (int)sizeof(maskKey); i++)
+    // create a random mask for the data
+    uint8_t* maskKey = header + headerSize;
+    for (int i = 0; i < 4; i++)
     {
         maskKey[i] = random(0xff);
     }
-    HttpClient::write(maskKey, sizeof(maskKey));
+    headerSize += 4;
 
-    // mask the data and send
-    for (int i = 0; i < (int)iTxSize; i++) {
-        iTxBuffer[i] ^= maskKey[i % sizeof(maskKey)];
-    }
+    // mask the data, then send it together with the header in one write by
+    // placing the header in the space reserved in front of the payload
+    uint8_t* payload = iTxBuffer + kMaxHeaderSize;
+    applyMask(payload, iTxSize, maskKey, 0);
+
+    uint8_t* frame = payload - headerSize;
+    memcpy(frame, header, headerSize);
 
-    size_t txSize = iTxSize;
+    size_t frameSize = headerSize + iTxSize;
 
     iTxStarted = false;
     iTxSize = 0;
 
-    return (HttpClient::write(iTxBuffer, txSize) == txSize) ? 0 : 1;
+    return (HttpClient::write(frame, frameSize) == frameSize) ? 0 : 1;
 }
 
 size_t WebSocketClient::write(uint8_t aByte)
@@ -165,13 +231,13 @@ size_t WebSocketClient::write(const uint8_t *aBuffer, size_t aSize)
     }
 
     // check if the write size, fits in the buffer
-    if ((iTxSize + aSize) > sizeof(iTxBuffer))
+    if ((iTxSize + aSize) > WS_TX_BUFFER_SIZE)
     {
-        aSize = sizeof(iTxSize) - iTxSize;
+        aSize = WS_TX_BUFFER_SIZE - iTxSize;
     }
 
-    // copy data into the buffer
-    memcpy(iTxBuffer + iTxSize, aBuffer, aSize);
+    // copy data into the buffer, after the space reserved for the header
+    memcpy(iTxBuffer + kMaxHeaderSize + iTxSize, aBuffer, aSize);
 
     iTxSize += aSize;
     
@@ -180,62 +246,60 @@ size_t WebSocketClient::write(const uint8_t *aBuffer, size_t aSize)
 
 int WebSocketClient::parseMessage()
 {
+    // drop what has arrived of the rest of the previous message, the next
+    // header can't be read until all of it has gone
     flushRx();
 
-    // make sure 2 bytes (opcode + length)
-    // are available
-    if (HttpClient::available() < 2)
+    if ((iRxSize > 0) || !receiveHeader())
     {
+        checkRxTimeout();
         return 0;
     }
 
-    // read open code and length
-    uint8_t opcode = HttpClient::read();
-    int length = HttpClient::read();
+    int length = iRxHeader[1] & 0x7f;
+    int lengthBytes = (length == 126) ? 2 : ((length == 127) ? 8 : 0);
 
-    if ((opcode & 0x0f) == 0)
+    // read the RX size
+    uint64_t size = length;
+    if (lengthBytes != 0)
     {
-        // continuation, use previous opcode and update flags
-        iRxOpCode |= opcode;
+        size = 0;
+        for (int i = 0; i < lengthBytes; i++)
+        {
+            size = (size << 8) | iRxHeader[2 + i];
+        }
     }
-    else
+
+    // a ping is answered as soon as it is parsed, so hold on to its header
+    // until the whole of the payload is here to send back
+    if (((iRxHeader[0] & 0x0f) == TYPE_PING) && ((uint64_t)HttpClient::available() < size))
     {
-        iRxOpCode = opcode;
+        checkRxTimeout();
+        return 0;
     }
 
-    iRxMasked = (length & 0x80);
-    length &= 0x7f;
+    uint8_t opcode = iRxHeader[0];
 
-    // read the RX size
-    if (length < 126)
-    {
-        iRxSize = length;
-    }
-    else if (length == 126)
+    if ((opcode & 0x0f) == 0)
     {
-        iRxSize = (HttpClient::read() << 8) | HttpClient::read();
+        // continuation, use previous opcode and update flags
+        iRxOpCode |= opcode;
     }
     else
     {
-        iRxSize = ((uint64_t)HttpClient::read() << 56) | 
-                    ((uint64_t)HttpClient::read() << 48) | 
-                    ((uint64_t)HttpClient::read() << 40) | 
-                    ((uint64_t)HttpClient::read() << 32) | 
-                    ((uint64_t)HttpClient::read() << 24) | 
-                    ((uint64_t)HttpClient::read() << 16) | 
-                    ((uint64_t)HttpClient::read() << 8)  |
-                    (uint64_t)HttpClient::read(); 
+        iRxOpCode = opcode;
     }
 
-    // read in the mask, if present
+    iRxSize = size;
+    iRxMasked = (iRxHeader[1] & 0x80);
+
+    // the mask, if present
     if (iRxMasked)
     {
-        for (int i = 0; i < (int)sizeof(iRxMaskKey); i++)
-        {
-            iRxMaskKey[i] = HttpClient::read();
-        }
+        memcpy(iRxMaskKey, iRxHeader + 2 + lengthBytes, sizeof(iRxMaskKey));
     }
 
+    iRxHeaderSize = 0;
     iRxMaskIndex = 0;
 
     if (TYPE_CONNECTION_CLOSE == messageType())
@@ -257,8 +321,10 @@ int WebSocketClient::parseMessage()
     }
     else if (TYPE_PONG == messageType())
     {
+        // whatever of the payload hasn't arrived yet is dropped by the
+        // next call
         flushRx();
-        iRxSize = 0;
+        return 0;
     }
 
     return iRxSize;
@@ -331,19 +397,23 @@ int WebSocketClient::read()
 
 int WebSocketClient::read(uint8_t *aBuffer, size_t aSize)
 {
+    if ((iState >= eReadingBody) && (aSize > iRxSize))
+    {
+        // don't read on into the next frame
+        aSize = iRxSize;
+    }
+
     int readCount = HttpClient::read(aBuffer, aSize);
 
     if (readCount > 0)
     {
         iRxSize -= readCount;
+        iRxLastData = millis();
 
         // unmask the RX data if needed
         if (iRxMasked)
         {
-            for (int i = 0; i < (int)aSize; i++, iRxMaskIndex++)
-            {
-                aBuffer[i] ^= iRxMaskKey[iRxMaskIndex % sizeof(iRxMaskKey)];
-            }
+            iRxMaskIndex = applyMask(aBuffer, readCount, iRxMaskKey, iRxMaskIndex);
         }
     }
 
@@ -357,16 +427,50 @@ int WebSocketClient::peek()
     if (p != -1 && iRxMasked)
     {
         // unmask the RX data if needed
-        p = (uint8_t)p ^ iRxMaskKey[iRxMaskIndex % sizeof(iRxMaskKey)];
+        p = (uint8_t)p ^ iRxMaskKey[iRxMaskIndex & 3];
     }
 
     return p;
 }
 
+bool WebSocketClient::receiveHeader()
+{
+    int size;
+
+    // the first two bytes give the size of the rest
+    while (iRxHeaderSize < (size = headerSize(iRxHeader, iRxHeaderSize)))
+    {
+        int ret = HttpClient::read(iRxHeader + iRxHeaderSize, size - iRxHeaderSize);
+        if (ret <= 0)
+        {
+            return false;
+        }
+
+        iRxHeaderSize += ret;
+        iRxLastData = millis();
+    }
+
+    return true;
+}
+
+void WebSocketClient::checkRxTimeout()
+{
+    if (((iRxSize > 0) || (iRxHeaderSize > 0)) && ((millis() - iRxLastData) >= httpResponseTimeout()))
+    {
+        // The rest of the frame isn't coming, and without it we can't
+        // find the start of the next one
+        stop();
+        iRxSize = 0;
+        iRxHeaderSize = 0;
+    }
+}
+
 void WebSocketClient::flushRx()
 {
-    while(available())
+    uint8_t discard[16];
+
+    // only what has arrived, the rest is left for a later call
+    while ((available() > 0) && (read(discard, sizeof(discard)) > 0))
     {
-        read();
     }
 }
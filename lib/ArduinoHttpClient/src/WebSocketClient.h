@@ -85,12 +85,27 @@ public:
     virtual int peek();
 
 private:
+    // Largest frame header: opcode, length, 64-bit extended length and mask key
+    static const int kMaxHeaderSize = 2 + 8 + 4;
+
     void flushRx();
 
+    /** Collect as much of the next frame header as has arrived, keeping
+        what there is until the rest turns up on a later call
+      @return true once the whole header has been received
+    */
+    bool receiveHeader();
+
+    /** Stop the connection if a frame that has started to arrive hasn't
+        moved on within the response timeout
+    */
+    void checkRxTimeout();
+
 private:
     bool iTxStarted;
     uint8_t iTxMessageType;
-    uint8_t iTxBuffer[WS_TX_BUFFER_SIZE];
+    // Space for the largest frame header, then WS_TX_BUFFER_SIZE of payload
+    uint8_t iTxBuffer[kMaxHeaderSize + WS_TX_BUFFER_SIZE];
     uint64_t iTxSize;
 
     uint8_t iRxOpCode;
@@ -98,6 +113,10 @@ private:
     bool iRxMasked;
     int iRxMaskIndex;
     uint8_t iRxMaskKey[4];
+    // Frame header received so far, and when the frame last moved on
+    uint8_t iRxHeader[kMaxHeaderSize];
+    int iRxHeaderSize;
+    unsigned long iRxLastData;
 };
 
 #endif
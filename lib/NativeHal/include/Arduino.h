@@ -0,0 +1,238 @@
+/* =====================================================================================================================
+ *      File:  /lib/NativeHal/include/Arduino.h
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef ARDUINO_H
+#define ARDUINO_H
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#include "pico/stdlib.h"
+
+
+
+
+//======================================================================================================================
+// Definitions
+//----------------------------------------------------------------------------------------------------------------------
+#define __time_critical_func(func_name) func_name
+#define __not_in_flash_func(func_name) func_name
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+#define LOW 0x0
+#define HIGH 0x1
+#define LED_BUILTIN 25
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+typedef uint8_t byte;
+
+using std::max;
+using std::min;
+
+
+
+
+//======================================================================================================================
+// String
+//----------------------------------------------------------------------------------------------------------------------
+/* Just enough of the Arduino String for the firmware and ArduinoHttpClient, backed by std::string.  Constructing from
+ * NULL gives an invalid string, as on target.
+ */
+class String
+{
+public:
+	String(const char * cstr = "") : _valid(cstr != NULL), _buffer(cstr ? cstr : "") {}
+	String(const String & other) = default;
+	explicit String(char c) : _valid(true), _buffer(1, c) {}
+	explicit String(int value) : _valid(true), _buffer(std::to_string(value)) {}
+	String & operator=(const String & other) = default;
+
+	unsigned int length(void) const { return _buffer.length(); }
+	const char * c_str(void) const { return _buffer.c_str(); }
+	operator bool(void) const { return _valid; }
+
+	unsigned char reserve(unsigned int size) { _buffer.reserve(size); return 1; }
+	unsigned char concat(char c) { _buffer += c; return 1; }
+	unsigned char concat(const char * cstr) { _buffer += cstr; return 1; }
+	unsigned char concat(const String & other) { _buffer += other._buffer; return 1; }
+
+	String & operator+=(char c) { concat(c); return *this; }
+	String & operator+=(const char * cstr) { concat(cstr); return *this; }
+	String & operator+=(const String & other) { concat(other); return *this; }
+
+	char operator[](unsigned int index) const { return index < _buffer.length() ? _buffer[index] : 0; }
+	char & operator[](unsigned int index) { return _buffer[index]; }
+	bool operator==(const String & other) const { return _buffer == other._buffer; }
+	bool operator==(const char * cstr) const { return _buffer == cstr; }
+	bool operator!=(const String & other) const { return _buffer != other._buffer; }
+
+	int indexOf(char c, unsigned int from = 0) const
+	{
+		size_t index = _buffer.find(c, from);
+		return index == std::string::npos ? -1 : (int)index;
+	}
+
+	String substring(unsigned int from, unsigned int to) const
+	{
+		return from >= _buffer.length() ? String() : String(_buffer.substr(from, to - from).c_str());
+	}
+
+	String substring(unsigned int from) const
+	{
+		return substring(from, _buffer.length());
+	}
+
+	long toInt(void) const { return strtol(_buffer.c_str(), NULL, 10); }
+	bool equalsIgnoreCase(const String & other) const { return strcasecmp(c_str(), other.c_str()) == 0; }
+
+private:
+	bool _valid;
+	std::string _buffer;
+};
+
+
+
+
+//======================================================================================================================
+// Print and Stream
+//----------------------------------------------------------------------------------------------------------------------
+class Print
+{
+public:
+	virtual ~Print() {}
+	virtual size_t write(uint8_t c) = 0;
+	virtual size_t write(const uint8_t * buffer, size_t size)
+	{
+		size_t written = 0;
+		while (size--)
+		{
+			written += write(*buffer++);
+		}
+		return written;
+	}
+	virtual void flush(void) {}
+
+	size_t write(const char * str) { return str ? write((const uint8_t *)str, strlen(str)) : 0; }
+
+	size_t print(const char * str) { return write(str); }
+	size_t print(const String & str) { return write(str.c_str()); }
+	size_t print(char c) { return write((uint8_t)c); }
+	size_t print(int value) { return print((long)value); }
+	size_t print(unsigned int value) { return print((unsigned long)value); }
+	size_t print(long value)
+	{
+		char buffer[24];
+		snprintf(buffer, sizeof(buffer), "%ld", value);
+		return write(buffer);
+	}
+	size_t print(unsigned long value)
+	{
+		char buffer[24];
+		snprintf(buffer, sizeof(buffer), "%lu", value);
+		return write(buffer);
+	}
+
+	size_t println(void) { return write("\r\n"); }
+	template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+};
+
+
+//----------------------------------------------------------------------------------------------------------------------
+class Stream : public Print
+{
+public:
+	virtual int available(void) = 0;
+	virtual int read(void) = 0;
+	virtual int peek(void) = 0;
+
+	void setTimeout(unsigned long timeout) { _timeout = timeout; }
+	size_t readBytes(char * buffer, size_t length) { return readBytes((uint8_t *)buffer, length); }
+	size_t readBytes(uint8_t * buffer, size_t length);
+
+protected:
+	int timedRead(void);
+	int timedPeek(void);
+
+	unsigned long _timeout = 1000;
+};
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Serial output goes to stdout. */
+class SerialStdout : public Stream
+{
+public:
+	void begin(unsigned long baud) { (void)baud; }
+	operator bool(void) { return true; }
+
+	size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+	int available(void) override { return 0; }
+	int read(void) override { return -1; }
+	int peek(void) override { return -1; }
+};
+
+extern SerialStdout Serial;
+
+
+
+
+//======================================================================================================================
+// Functions
+//----------------------------------------------------------------------------------------------------------------------
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+
+static inline bool isAlphaNumeric(int c) { return isalnum(c) != 0; }
+static inline bool isHexadecimalDigit(int c) { return isxdigit(c) != 0; }
+static inline bool isSpace(int c) { return isspace(c) != 0; }
+
+void setup(void);
+void loop(void);
+void setup1(void);
+void loop1(void);
+
+
+
+
+#endif
+/* End of File */
@@ -0,0 +1,58 @@
+/* =====================================================================================================================
+ *      File:  /lib/NativeHal/include/Client.h
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef CLIENT_H
+#define CLIENT_H
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "Arduino.h"
+#include "IPAddress.h"
+
+
+
+
+//======================================================================================================================
+// Client
+//----------------------------------------------------------------------------------------------------------------------
+class Client : public Stream
+{
+public:
+	virtual int connect(IPAddress ip, uint16_t port) = 0;
+	virtual int connect(const char * host, uint16_t port) = 0;
+	virtual size_t write(uint8_t c) = 0;
+	virtual size_t write(const uint8_t * buffer, size_t size) = 0;
+	virtual int available(void) = 0;
+	virtual int read(void) = 0;
+	virtual int read(uint8_t * buffer, size_t size) = 0;
+	virtual int peek(void) = 0;
+	virtual void flush(void) = 0;
+	virtual void stop(void) = 0;
+	virtual uint8_t connected(void) = 0;
+	virtual operator bool(void) = 0;
+
+	using Print::write;
+};
+
+
+
+
+#endif
+/* End of File */
@@ -0,0 +1,81 @@
+/* =====================================================================================================================
+ *      File:  /lib/NativeHal/include/WiFi.h
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef WIFI_H
+#define WIFI_H
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "Client.h"
+
+
+
+
+//======================================================================================================================
+// Definitions
+//----------------------------------------------------------------------------------------------------------------------
+#define WL_IDLE_STATUS 0
+#define WL_CONNECTED 3
+#define WL_DISCONNECTED 6
+
+
+
+
+//======================================================================================================================
+// WiFi
+//----------------------------------------------------------------------------------------------------------------------
+/* There is no network on the host: WiFi never connects and clients never open. */
+class WiFiClass
+{
+public:
+	int begin(const char * ssid, const char * pass) { (void)ssid; (void)pass; return WL_DISCONNECTED; }
+	int status(void) { return WL_DISCONNECTED; }
+};
+
+extern WiFiClass WiFi;
+
+
+//----------------------------------------------------------------------------------------------------------------------
+class WiFiClient : public Client
+{
+public:
+	int connect(IPAddress ip, uint16_t port) override { (void)ip; (void)port; return 0; }
+	int connect(const char * host, uint16_t port) override { (void)host; (void)port; return 0; }
+	size_t write(uint8_t c) override { (void)c; return 0; }
+	size_t write(const uint8_t * buffer, size_t size) override { (void)buffer; (void)size; return 0; }
+	int available(void) override { return 0; }
+	int read(void) override { return -1; }
+	int read(uint8_t * buffer, size_t size) override { (void)buffer; (void)size; return -1; }
+	int peek(void) override { return -1; }
+	void flush(void) override {}
+	void stop(void) override {}
+	uint8_t connected(void) override { return 0; }
+	operator bool(void) override { return false; }
+
+	void setNoDelay(bool nodelay) { (void)nodelay; }
+
+	using Print::write;
+};
+
+
+
+
+#endif
+/* End of File */
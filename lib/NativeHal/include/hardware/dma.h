@@ -0,0 +1,153 @@
+/* =====================================================================================================================
+ *      File:  /lib/NativeHal/include/hardware/dma.h
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef HARDWARE_DMA_H
+#define HARDWARE_DMA_H
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+
+
+
+//======================================================================================================================
+// Definitions
+//----------------------------------------------------------------------------------------------------------------------
+#define NUM_DMA_CHANNELS 12
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+typedef unsigned int uint;
+
+enum dma_channel_transfer_size
+{
+	DMA_SIZE_8 = 0,
+	DMA_SIZE_16 = 1,
+	DMA_SIZE_32 = 2,
+};
+
+typedef struct
+{
+	enum dma_channel_transfer_size size;
+	bool read_increment;
+	bool write_increment;
+	uint dreq;
+	uint chain_to;
+	bool ring_write;
+	uint ring_bits;
+	bool irq_quiet;
+} dma_channel_config;
+
+// Register layout matches the RP2040 so the firmware can take the address of trigger aliases.
+typedef struct
+{
+	volatile uint32_t read_addr;
+	volatile uint32_t write_addr;
+	volatile uint32_t transfer_count;
+	volatile uint32_t ctrl_trig;
+	volatile uint32_t al1_ctrl;
+	volatile uint32_t al1_read_addr;
+	volatile uint32_t al1_write_addr;
+	volatile uint32_t al1_transfer_count_trig;
+	volatile uint32_t al2_ctrl;
+	volatile uint32_t al2_transfer_count;
+	volatile uint32_t al2_read_addr;
+	volatile uint32_t al2_write_addr_trig;
+	volatile uint32_t al3_ctrl;
+	volatile uint32_t al3_write_addr;
+	volatile uint32_t al3_transfer_count;
+	volatile uint32_t al3_read_addr_trig;
+} dma_channel_hw_t;
+
+typedef struct
+{
+	dma_channel_hw_t ch[NUM_DMA_CHANNELS];
+} dma_hw_t;
+
+extern dma_hw_t native_dma_hw;
+#define dma_hw (&native_dma_hw)
+
+
+
+
+//======================================================================================================================
+// Functions
+//----------------------------------------------------------------------------------------------------------------------
+int dma_claim_unused_channel(bool required);
+dma_channel_config dma_channel_get_default_config(uint channel);
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config * c, enum dma_channel_transfer_size size)
+{
+	c->size = size;
+}
+
+static inline void channel_config_set_read_increment(dma_channel_config * c, bool incr)
+{
+	c->read_increment = incr;
+}
+
+static inline void channel_config_set_write_increment(dma_channel_config * c, bool incr)
+{
+	c->write_increment = incr;
+}
+
+static inline void channel_config_set_dreq(dma_channel_config * c, uint dreq)
+{
+	c->dreq = dreq;
+}
+
+static inline void channel_config_set_chain_to(dma_channel_config * c, uint chain_to)
+{
+	c->chain_to = chain_to;
+}
+
+static inline void channel_config_set_ring(dma_channel_config * c, bool write, uint size_bits)
+{
+	c->ring_write = write;
+	c->ring_bits = size_bits;
+}
+
+static inline void channel_config_set_irq_quiet(dma_channel_config * c, bool irq_quiet)
+{
+	c->irq_quiet = irq_quiet;
+}
+
+dma_channel_config dma_get_channel_config(uint channel);
+void dma_channel_set_config(uint channel, const dma_channel_config * config, bool trigger);
+void dma_channel_configure(uint channel, const dma_channel_config * config, volatile void * write_addr,
+	const volatile void * read_addr, uint transfer_count, bool trigger);
+void dma_channel_set_read_addr(uint channel, const volatile void * read_addr, bool trigger);
+void dma_channel_set_write_addr(uint channel, volatile void * write_addr, bool trigger);
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger);
+void dma_channel_start(uint channel);
+void dma_channel_abort(uint channel);
+bool dma_channel_is_busy(uint channel);
+void dma_channel_wait_for_finish_blocking(uint channel);
+
+
+
+
+#endif
+/* End of File */
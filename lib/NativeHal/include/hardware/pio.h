@@ -0,0 +1,233 @@
+/* =====================================================================================================================
+ *      File:  /lib/NativeHal/include/hardware/pio.h
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef HARDWARE_PIO_H
+#define HARDWARE_PIO_H
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+
+
+
+//======================================================================================================================
+// Definitions
+//----------------------------------------------------------------------------------------------------------------------
+#define NUM_PIO_STATE_MACHINES 4
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+typedef unsigned int uint;
+
+typedef struct
+{
+	volatile uint32_t clkdiv;
+	volatile uint32_t execctrl;
+	volatile uint32_t shiftctrl;
+	volatile uint32_t addr;
+	volatile uint32_t instr;
+	volatile uint32_t pinctrl;
+} pio_sm_hw_t;
+
+typedef struct
+{
+	volatile uint32_t ctrl;
+	volatile uint32_t fstat;
+	volatile uint32_t fdebug;
+	volatile uint32_t flevel;
+	volatile uint32_t txf[NUM_PIO_STATE_MACHINES];
+	volatile uint32_t rxf[NUM_PIO_STATE_MACHINES];
+	pio_sm_hw_t sm[NUM_PIO_STATE_MACHINES];
+} pio_hw_t;
+
+typedef pio_hw_t * PIO;
+
+extern pio_hw_t native_pio0_hw;
+extern pio_hw_t native_pio1_hw;
+#define pio0 (&native_pio0_hw)
+#define pio1 (&native_pio1_hw)
+
+typedef struct
+{
+	float clkdiv;
+	uint32_t execctrl;
+	uint32_t shiftctrl;
+	uint32_t pinctrl;
+} pio_sm_config;
+
+typedef struct pio_program
+{
+	const uint16_t * instructions;
+	uint8_t length;
+	int8_t origin;
+} pio_program_t;
+
+enum pio_fifo_join
+{
+	PIO_FIFO_JOIN_NONE = 0,
+	PIO_FIFO_JOIN_TX = 1,
+	PIO_FIFO_JOIN_RX = 2,
+};
+
+enum pio_src_dest
+{
+	pio_pins = 0u,
+	pio_x = 1u,
+	pio_y = 2u,
+	pio_null = 3u,
+	pio_pindirs = 4u,
+	pio_exec_mov = 4u,
+	pio_status = 5u,
+	pio_pc = 5u,
+	pio_isr = 6u,
+	pio_osr = 7u,
+	pio_exec_out = 7u,
+};
+
+
+
+
+//======================================================================================================================
+// Configuration
+//----------------------------------------------------------------------------------------------------------------------
+static inline pio_sm_config pio_get_default_sm_config(void)
+{
+	pio_sm_config c = { 1.0f, 0, 0, 0 };
+	return c;
+}
+
+static inline void sm_config_set_wrap(pio_sm_config * c, uint wrap_target, uint wrap)
+{
+	c->execctrl = (wrap_target << 7) | (wrap << 12);
+}
+
+static inline void sm_config_set_sideset(pio_sm_config * c, uint bit_count, bool optional, bool pindirs)
+{
+	(void)c; (void)bit_count; (void)optional; (void)pindirs;
+}
+
+static inline void sm_config_set_out_pins(pio_sm_config * c, uint out_base, uint out_count)
+{
+	(void)c; (void)out_base; (void)out_count;
+}
+
+static inline void sm_config_set_set_pins(pio_sm_config * c, uint set_base, uint set_count)
+{
+	(void)c; (void)set_base; (void)set_count;
+}
+
+static inline void sm_config_set_sideset_pins(pio_sm_config * c, uint sideset_base)
+{
+	(void)c; (void)sideset_base;
+}
+
+static inline void sm_config_set_out_shift(pio_sm_config * c, bool shift_right, bool autopull, uint pull_threshold)
+{
+	(void)c; (void)shift_right; (void)autopull; (void)pull_threshold;
+}
+
+static inline void sm_config_set_in_shift(pio_sm_config * c, bool shift_right, bool autopush, uint push_threshold)
+{
+	(void)c; (void)shift_right; (void)autopush; (void)push_threshold;
+}
+
+static inline void sm_config_set_fifo_join(pio_sm_config * c, enum pio_fifo_join join)
+{
+	(void)c; (void)join;
+}
+
+static inline void sm_config_set_clkdiv(pio_sm_config * c, float div)
+{
+	c->clkdiv = div;
+}
+
+
+
+
+//======================================================================================================================
+// Instruction Encoding
+//----------------------------------------------------------------------------------------------------------------------
+static inline uint pio_encode_jmp(uint addr)
+{
+	return 0x0000u | (addr & 0x1fu);
+}
+
+static inline uint pio_encode_in(enum pio_src_dest src, uint count)
+{
+	return 0x4000u | ((src & 7u) << 5) | (count & 0x1fu);
+}
+
+static inline uint pio_encode_out(enum pio_src_dest dest, uint count)
+{
+	return 0x6000u | ((dest & 7u) << 5) | (count & 0x1fu);
+}
+
+static inline uint pio_encode_pull(bool if_empty, bool block)
+{
+	return 0x8080u | (if_empty ? 0x40u : 0) | (block ? 0x20u : 0);
+}
+
+static inline uint pio_encode_mov(enum pio_src_dest dest, enum pio_src_dest src)
+{
+	return 0xa000u | ((dest & 7u) << 5) | (src & 7u);
+}
+
+static inline uint pio_encode_set(enum pio_src_dest dest, uint value)
+{
+	return 0xe000u | ((dest & 7u) << 5) | (value & 0x1fu);
+}
+
+
+
+
+//======================================================================================================================
+// Functions
+//----------------------------------------------------------------------------------------------------------------------
+uint pio_add_program(PIO pio, const pio_program_t * program);
+int pio_claim_unused_sm(PIO pio, bool required);
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx);
+void pio_gpio_init(PIO pio, uint pin);
+
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config * config);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+void pio_sm_restart(PIO pio, uint sm);
+void pio_sm_clear_fifos(PIO pio, uint sm);
+void pio_sm_set_pins_with_mask(PIO pio, uint sm, uint32_t pin_values, uint32_t pin_mask);
+void pio_sm_set_pindirs_with_mask(PIO pio, uint sm, uint32_t pin_dirs, uint32_t pin_mask);
+void pio_sm_exec(PIO pio, uint sm, uint instr);
+void pio_sm_put(PIO pio, uint sm, uint32_t data);
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data);
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm);
+
+static inline uint pio_get_index(PIO pio)
+{
+	return pio == pio1 ? 1 : 0;
+}
+
+
+
+
+#endif
+/* End of File */
@@ -0,0 +1,72 @@
+/* =====================================================================================================================
+ *      File:  /lib/NativeHal/include/native.h
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef NATIVE_H
+#define NATIVE_H
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+#include "hardware/pio.h"
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Called for every DMA transfer the firmware triggers.  data points at the source words when the read address
+// increments, otherwise at the single repeated word.
+typedef void (*native_dma_listener_t)(uint channel, volatile void * write_addr, const uint32_t * data, uint32_t count);
+
+// Called for every word written to a PIO TX FIFO by the CPU.
+typedef void (*native_pio_listener_t)(PIO pio, uint sm, uint32_t value);
+
+
+
+
+//======================================================================================================================
+// Functions
+//----------------------------------------------------------------------------------------------------------------------
+/* Host-side controls for the HAL shim, used by native tools to drive and observe the firmware.
+ *
+ * Time runs from the host monotonic clock until native_time_manual() is called, after which it only moves when set or
+ * advanced.  DMA transfers complete instantly when triggered; DREQ pacing, chaining and PIO programs are not emulated,
+ * so the streamed column output produces no data on the host.
+ */
+void native_time_manual(bool manual);
+void native_time_set_us(uint64_t us);
+void native_time_advance_us(uint64_t us);
+
+void native_gpio_event(uint gpio, uint32_t events);
+
+void native_set_dma_listener(native_dma_listener_t listener);
+void native_set_pio_listener(native_pio_listener_t listener);
+
+bool native_pio_tx_address(volatile void * address, PIO * pio, uint * sm);
+
+bool native_flash_load(uint32_t offset, const char * path);
+
+
+
+
+#endif
+/* End of File */
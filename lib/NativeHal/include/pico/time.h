@@ -0,0 +1,75 @@
+/* =====================================================================================================================
+ *      File:  /lib/NativeHal/include/pico/time.h
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef PICO_TIME_H
+#define PICO_TIME_H
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+typedef uint64_t absolute_time_t;
+
+static const absolute_time_t nil_time = 0;
+
+
+
+
+//======================================================================================================================
+// Functions
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t time_us_64(void);
+
+static inline uint32_t time_us_32(void)
+{
+	return (uint32_t)time_us_64();
+}
+
+static inline absolute_time_t get_absolute_time(void)
+{
+	return time_us_64();
+}
+
+static inline bool is_nil_time(absolute_time_t t)
+{
+	return t == nil_time;
+}
+
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to)
+{
+	return (int64_t)(to - from);
+}
+
+static inline uint64_t to_us_since_boot(absolute_time_t t)
+{
+	return t;
+}
+
+
+
+
+#endif
+/* End of File */
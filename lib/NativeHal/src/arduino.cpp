@@ -0,0 +1,220 @@
+/* =====================================================================================================================
+ *      File:  /lib/NativeHal/src/arduino.cpp
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <chrono>
+#include <thread>
+
+#include "Arduino.h"
+#include "WiFi.h"
+#include "native.h"
+
+
+
+
+//======================================================================================================================
+// Module Variables
+//----------------------------------------------------------------------------------------------------------------------
+static bool _manual_time = false;
+static uint64_t _time_us = 0;
+static const std::chrono::steady_clock::time_point _boot = std::chrono::steady_clock::now();
+
+SerialStdout Serial;
+WiFiClass WiFi;
+
+
+
+
+//======================================================================================================================
+// Time
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t time_us_64(void)
+{
+	if (_manual_time)
+	{
+		return _time_us;
+	}
+
+	auto elapsed = std::chrono::steady_clock::now() - _boot;
+	return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void native_time_manual(bool manual)
+{
+	_time_us = time_us_64();
+	_manual_time = manual;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void native_time_set_us(uint64_t us)
+{
+	_time_us = us;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void native_time_advance_us(uint64_t us)
+{
+	_time_us += us;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+unsigned long millis(void)
+{
+	return (unsigned long)(time_us_64() / 1000);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+unsigned long micros(void)
+{
+	return (unsigned long)time_us_64();
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void delay(unsigned long ms)
+{
+	if (_manual_time)
+	{
+		_time_us += (uint64_t)ms * 1000;
+	}
+	else
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+	}
+}
+
+
+
+
+//======================================================================================================================
+// Pins and Random
+//----------------------------------------------------------------------------------------------------------------------
+void pinMode(uint8_t pin, uint8_t mode)
+{
+	(void)pin;
+	(void)mode;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+	(void)pin;
+	(void)value;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+int digitalRead(uint8_t pin)
+{
+	(void)pin;
+	return LOW;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+long random(long howbig)
+{
+	return howbig > 0 ? rand() % howbig : 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+long random(long howsmall, long howbig)
+{
+	return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+
+
+
+//======================================================================================================================
+// Stream
+//----------------------------------------------------------------------------------------------------------------------
+int Stream::timedRead(void)
+{
+	unsigned long start = millis();
+	do
+	{
+		int c = read();
+		if (c >= 0)
+		{
+			return c;
+		}
+		if (_manual_time)
+		{
+			// Nothing else will advance time while we wait.
+			_time_us += 1000;
+		}
+	} while (millis() - start < _timeout);
+
+	return -1;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+int Stream::timedPeek(void)
+{
+	unsigned long start = millis();
+	do
+	{
+		int c = peek();
+		if (c >= 0)
+		{
+			return c;
+		}
+		if (_manual_time)
+		{
+			_time_us += 1000;
+		}
+	} while (millis() - start < _timeout);
+
+	return -1;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+size_t Stream::readBytes(uint8_t * buffer, size_t length)
+{
+	size_t count = 0;
+	while (count < length)
+	{
+		int c = timedRead();
+		if (c < 0)
+		{
+			break;
+		}
+		buffer[count++] = (uint8_t)c;
+	}
+	return count;
+}
+
+
+
+
+/* End of File */
@@ -0,0 +1,496 @@
+/* =====================================================================================================================
+ *      File:  /lib/NativeHal/src/pico.cpp
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hardware/dma.h"
+#include "hardware/flash.h"
+#include "hardware/gpio.h"
+#include "hardware/pio.h"
+#include "pico/sync.h"
+#include "native.h"
+
+
+
+
+//======================================================================================================================
+// Definitions
+//----------------------------------------------------------------------------------------------------------------------
+#define NUM_GPIOS 30
+#define PIO_INSTRUCTION_COUNT 32
+
+// Mirrors the RP2040 DREQ numbering so pio_get_dreq() values look familiar in a debugger.
+#define DREQ_PIO0_TX0 0
+#define DREQ_PIO0_RX0 4
+#define DREQ_PIO1_TX0 8
+#define DREQ_PIO1_RX0 12
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+typedef struct
+{
+	bool claimed;
+	dma_channel_config config;
+	const volatile void * read_addr;
+	volatile void * write_addr;
+	uint32_t trans_count;
+} DmaChannel_t;
+
+
+
+
+//======================================================================================================================
+// Module Variables
+//----------------------------------------------------------------------------------------------------------------------
+dma_hw_t native_dma_hw;
+pio_hw_t native_pio0_hw;
+pio_hw_t native_pio1_hw;
+uint8_t native_flash[PICO_FLASH_SIZE_BYTES];
+
+static DmaChannel_t _dma[NUM_DMA_CHANNELS];
+static uint8_t _pio_used[2];
+static uint8_t _pio_claimed[2];
+static gpio_irq_callback_t _gpio_callback;
+static uint32_t _gpio_events[NUM_GPIOS];
+
+static native_dma_listener_t _dma_listener;
+static native_pio_listener_t _pio_listener;
+
+
+
+
+//======================================================================================================================
+// Helpers
+//----------------------------------------------------------------------------------------------------------------------
+/* Perform a triggered transfer immediately and report it to the listener. */
+static void _dma_run(uint channel)
+{
+	DmaChannel_t * dma = &_dma[channel];
+	if (!dma->trans_count)
+	{
+		return;
+	}
+
+	if (_dma_listener)
+	{
+		_dma_listener(channel, dma->write_addr, (const uint32_t *)dma->read_addr, dma->trans_count);
+	}
+
+	if (dma->config.read_increment)
+	{
+		uint32_t stride = 1u << dma->config.size;
+		dma->read_addr = (const volatile uint8_t *)dma->read_addr + stride * dma->trans_count;
+	}
+}
+
+
+
+
+//======================================================================================================================
+// Host Controls
+//----------------------------------------------------------------------------------------------------------------------
+void native_gpio_event(uint gpio, uint32_t events)
+{
+	if (_gpio_callback && (gpio < NUM_GPIOS) && (_gpio_events[gpio] & events))
+	{
+		_gpio_callback(gpio, _gpio_events[gpio] & events);
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void native_set_dma_listener(native_dma_listener_t listener)
+{
+	_dma_listener = listener;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void native_set_pio_listener(native_pio_listener_t listener)
+{
+	_pio_listener = listener;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Copy a file into flash at offset, as picotool would write it.  Returns false if it can't be read or won't fit. */
+bool native_flash_load(uint32_t offset, const char * path)
+{
+	FILE * file = fopen(path, "rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	if (offset > sizeof(native_flash))
+	{
+		fclose(file);
+		return false;
+	}
+
+	size_t length = fread(&native_flash[offset], 1, sizeof(native_flash) - offset, file);
+	bool fits = (fgetc(file) == EOF) && !ferror(file);
+	fclose(file);
+
+	return fits && (length > 0);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Report which state machine, if any, a DMA write address feeds. */
+bool native_pio_tx_address(volatile void * address, PIO * pio, uint * sm)
+{
+	PIO pios[] = { pio0, pio1 };
+	for (PIO candidate : pios)
+	{
+		for (uint idx = 0; idx < NUM_PIO_STATE_MACHINES; idx++)
+		{
+			if (address == &candidate->txf[idx])
+			{
+				*pio = candidate;
+				*sm = idx;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+
+
+
+//======================================================================================================================
+// GPIO and Sync
+//----------------------------------------------------------------------------------------------------------------------
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback)
+{
+	if (gpio >= NUM_GPIOS)
+	{
+		return;
+	}
+	_gpio_callback = callback;
+	_gpio_events[gpio] = enabled ? (_gpio_events[gpio] | event_mask) : (_gpio_events[gpio] & ~event_mask);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void critical_section_init(critical_section_t * crit_sec)
+{
+	crit_sec->locked = false;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void critical_section_enter_blocking(critical_section_t * crit_sec)
+{
+	while (__atomic_exchange_n(&crit_sec->locked, true, __ATOMIC_ACQUIRE));
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void critical_section_exit(critical_section_t * crit_sec)
+{
+	__atomic_store_n(&crit_sec->locked, false, __ATOMIC_RELEASE);
+}
+
+
+
+
+//======================================================================================================================
+// DMA
+//----------------------------------------------------------------------------------------------------------------------
+int dma_claim_unused_channel(bool required)
+{
+	for (uint channel = 0; channel < NUM_DMA_CHANNELS; channel++)
+	{
+		if (!_dma[channel].claimed)
+		{
+			_dma[channel].claimed = true;
+			return channel;
+		}
+	}
+	if (required)
+	{
+		abort();
+	}
+	return -1;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+dma_channel_config dma_channel_get_default_config(uint channel)
+{
+	dma_channel_config config = {};
+	config.size = DMA_SIZE_32;
+	config.read_increment = true;
+	config.write_increment = false;
+	config.dreq = 0x3f;
+	config.chain_to = channel;
+	return config;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+dma_channel_config dma_get_channel_config(uint channel)
+{
+	return _dma[channel].config;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void dma_channel_set_config(uint channel, const dma_channel_config * config, bool trigger)
+{
+	_dma[channel].config = *config;
+	if (trigger)
+	{
+		_dma_run(channel);
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void dma_channel_configure(uint channel, const dma_channel_config * config, volatile void * write_addr,
+	const volatile void * read_addr, uint transfer_count, bool trigger)
+{
+	_dma[channel].config = *config;
+	_dma[channel].write_addr = write_addr;
+	_dma[channel].read_addr = read_addr;
+	_dma[channel].trans_count = transfer_count;
+	if (trigger)
+	{
+		_dma_run(channel);
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void dma_channel_set_read_addr(uint channel, const volatile void * read_addr, bool trigger)
+{
+	_dma[channel].read_addr = read_addr;
+	if (trigger)
+	{
+		_dma_run(channel);
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void dma_channel_set_write_addr(uint channel, volatile void * write_addr, bool trigger)
+{
+	_dma[channel].write_addr = write_addr;
+	if (trigger)
+	{
+		_dma_run(channel);
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger)
+{
+	_dma[channel].trans_count = trans_count;
+	if (trigger)
+	{
+		_dma_run(channel);
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void dma_channel_start(uint channel)
+{
+	_dma_run(channel);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void dma_channel_abort(uint channel)
+{
+	(void)channel;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+bool dma_channel_is_busy(uint channel)
+{
+	(void)channel;
+	return false;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void dma_channel_wait_for_finish_blocking(uint channel)
+{
+	(void)channel;
+}
+
+
+
+
+//======================================================================================================================
+// PIO
+//----------------------------------------------------------------------------------------------------------------------
+uint pio_add_program(PIO pio, const pio_program_t * program)
+{
+	uint index = pio_get_index(pio);
+	uint offset = _pio_used[index];
+	_pio_used[index] += program->length;
+	if (_pio_used[index] > PIO_INSTRUCTION_COUNT)
+	{
+		abort();
+	}
+	return offset;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+int pio_claim_unused_sm(PIO pio, bool required)
+{
+	uint index = pio_get_index(pio);
+	for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++)
+	{
+		if (!(_pio_claimed[index] & (1u << sm)))
+		{
+			_pio_claimed[index] |= 1u << sm;
+			return sm;
+		}
+	}
+	if (required)
+	{
+		abort();
+	}
+	return -1;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx)
+{
+	uint base = pio == pio1 ? (is_tx ? DREQ_PIO1_TX0 : DREQ_PIO1_RX0) : (is_tx ? DREQ_PIO0_TX0 : DREQ_PIO0_RX0);
+	return base + sm;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void pio_gpio_init(PIO pio, uint pin)
+{
+	(void)pio;
+	(void)pin;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config * config)
+{
+	pio->sm[sm].execctrl = config->execctrl;
+	pio->sm[sm].shiftctrl = config->shiftctrl;
+	pio->sm[sm].pinctrl = config->pinctrl;
+	pio->sm[sm].addr = initial_pc;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled)
+{
+	pio->ctrl = enabled ? (pio->ctrl | (1u << sm)) : (pio->ctrl & ~(1u << sm));
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void pio_sm_restart(PIO pio, uint sm)
+{
+	(void)pio;
+	(void)sm;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void pio_sm_clear_fifos(PIO pio, uint sm)
+{
+	(void)pio;
+	(void)sm;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void pio_sm_set_pins_with_mask(PIO pio, uint sm, uint32_t pin_values, uint32_t pin_mask)
+{
+	(void)pio;
+	(void)sm;
+	(void)pin_values;
+	(void)pin_mask;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void pio_sm_set_pindirs_with_mask(PIO pio, uint sm, uint32_t pin_dirs, uint32_t pin_mask)
+{
+	(void)pio;
+	(void)sm;
+	(void)pin_dirs;
+	(void)pin_mask;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void pio_sm_exec(PIO pio, uint sm, uint instr)
+{
+	pio->sm[sm].instr = instr;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void pio_sm_put(PIO pio, uint sm, uint32_t data)
+{
+	pio->txf[sm] = data;
+	if (_pio_listener)
+	{
+		_pio_listener(pio, sm, data);
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data)
+{
+	pio_sm_put(pio, sm, data);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm)
+{
+	(void)pio;
+	(void)sm;
+	return true;
+}
+
+
+
+
+/* End of File */
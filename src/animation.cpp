@@ -0,0 +1,171 @@
+/* =====================================================================================================================
+ *      File:  /src/animation.cpp
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "animation.h"
+#include "constants.h"
+#include "renderer.h"
+
+
+
+
+//======================================================================================================================
+// Module Variables
+//----------------------------------------------------------------------------------------------------------------------
+static const LibraryImage_t * _image;
+static uint16_t _frame;
+static uint32_t _period_us;
+static uint32_t _due_us;
+static AnimationStats_t _stats;
+
+// Due time of a frame whose commit was put off, while _deferred.
+static bool _deferred;
+static uint32_t _deferred_due_us;
+
+
+
+
+//======================================================================================================================
+// Helpers
+//----------------------------------------------------------------------------------------------------------------------
+/* Count a frame that has been committed lateness microseconds after it was due. */
+static void _count_frame(uint32_t lateness)
+{
+	_stats.frames++;
+	if (lateness > _period_us / 2)
+	{
+		_stats.late++;
+	}
+	if (lateness > _stats.late_max_us)
+	{
+		_stats.late_max_us = lateness;
+	}
+}
+
+
+
+
+//======================================================================================================================
+// Animation
+//----------------------------------------------------------------------------------------------------------------------
+/* Show a library image, stepping through its frames if it has more than one.  NULL goes back to the built-in
+ * regions.
+ */
+void animation_play(const LibraryImage_t * image)
+{
+	_image = (image && (image->frame_count > 1)) ? image : NULL;
+	_frame = 0;
+	_stats = {};
+	_deferred = false;
+
+	renderer_set_image(image, 0);
+	renderer_commit();
+
+	if (_image)
+	{
+		_period_us = (_image->frame_time ? _image->frame_time : ANIMATION_FRAME_TIME) * 1000;
+		_due_us = micros() + _period_us;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Draw and commit the next frame once it is due.  Call as often as possible from the rendering core.
+ *
+ * Frames are timed from the clock, not from the revolution, so the animation runs at the same rate whatever the
+ * speed of the globe.  The output core picks up each frame as it is committed, without either core waiting on the
+ * other, and when rendering falls behind whole frames are dropped to keep to the schedule rather than slowing down.
+ * A commit put off because the output core held every buffer is retried by renderer_commit() from the loop, and the
+ * frame is counted, late, once it has gone out.
+ */
+void animation_service(void)
+{
+	if (!_image)
+	{
+		return;
+	}
+
+	uint32_t now = micros();
+	if (_deferred && !renderer_pending())
+	{
+		// The put off commit has gone out since the last call, which is as close as its time can be told.
+		_deferred = false;
+		_count_frame(now - _deferred_due_us);
+	}
+
+	int32_t behind = (int32_t)(now - _due_us);
+	if (behind < 0)
+	{
+		return;
+	}
+
+	if (_deferred)
+	{
+		// Still waiting on a buffer when the next frame is due, it is replaced without ever being shown.
+		_deferred = false;
+		_stats.dropped++;
+	}
+
+	uint32_t missed = (uint32_t)behind / _period_us;
+	uint32_t due = _due_us + missed * _period_us;
+	_frame = (_frame + 1 + missed) % _image->frame_count;
+	_due_us = due + _period_us;
+	_stats.dropped += missed;
+
+	renderer_set_image(_image, _frame);
+	renderer_commit();
+
+	uint32_t finished = micros();
+	_stats.render_last_us = finished - now;
+	if (_stats.render_last_us > _stats.render_max_us)
+	{
+		_stats.render_max_us = _stats.render_last_us;
+	}
+	if (renderer_pending())
+	{
+		_stats.deferred++;
+		_deferred = true;
+		_deferred_due_us = due;
+		return;
+	}
+
+	_count_frame(finished - due);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+bool animation_playing(void)
+{
+	return _image != NULL;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+const AnimationStats_t * animation_stats(void)
+{
+	return &_stats;
+}
+
+
+
+
+/* End of File */
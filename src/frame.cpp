@@ -0,0 +1,77 @@
+/* =====================================================================================================================
+ *      File:  /src/frame.cpp
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "frame.h"
+
+
+
+
+//======================================================================================================================
+// Frame Functions
+//----------------------------------------------------------------------------------------------------------------------
+/* Reset a column buffer to black, including any start and end frames. */
+void frame_clear_column(Column_t * column)
+{
+#if PIXEL_FORMAT == PIXEL_FORMAT_RGB555
+	for (uint8_t idx = 0; idx < COLUMN_WORDS; idx++)
+	{
+		(*column)[idx] = 0;
+	}
+#else
+	(*column)[0] = 0;
+	for (uint8_t idx = 1; idx <= LED_COUNT; idx++)
+	{
+		(*column)[idx] = convert_rgb_to_apa102(0);
+	}
+	(*column)[COLUMN_WORDS - 1] = ~0;
+#endif
+}
+
+
+#if PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+//----------------------------------------------------------------------------------------------------------------------
+/* Reset a column of palette indices to the background. */
+void frame_clear_column(IndexColumn_t * column)
+{
+	for (uint8_t idx = 0; idx < LED_COUNT; idx++)
+	{
+		(*column)[idx] = 0;
+	}
+}
+#endif
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void frame_clear(Frame_t * frame)
+{
+	for (uint8_t column = 0; column < RES_HORIZ; column++)
+	{
+		frame_clear_column(&frame->left[column]);
+		frame_clear_column(&frame->right[column]);
+	}
+}
+
+
+
+
+/* End of File */
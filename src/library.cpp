@@ -0,0 +1,177 @@
+/* =====================================================================================================================
+ *      File:  /src/library.cpp
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "library.h"
+
+
+
+
+//======================================================================================================================
+// Module Variables
+//----------------------------------------------------------------------------------------------------------------------
+static const uint8_t * _base;
+static const LibraryHeader_t * _header;
+
+
+
+
+//======================================================================================================================
+// Helpers
+//----------------------------------------------------------------------------------------------------------------------
+/* Check that a table of count entries of a given size starts aligned and ends within the library. */
+static inline bool _fits(uint32_t offset, uint32_t count, uint32_t entry, uint32_t alignment, uint32_t size)
+{
+	return ((offset % alignment) == 0) && (offset <= size) && (count <= (size - offset) / entry);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Check everything the renderer will follow in an image, so that drawing never has to. */
+static bool _valid_image(const uint8_t * base, const LibraryImage_t * image, uint32_t size)
+{
+	if ((image->frame_count == 0) || (image->color_count >= PALETTE_SIZE)
+		|| !_fits(image->colors, image->color_count, sizeof(uint32_t), 4, size)
+		|| !_fits(image->frames, image->frame_count, sizeof(uint32_t), 4, size))
+	{
+		return false;
+	}
+
+	const uint32_t * frames = (const uint32_t *)(base + image->frames);
+	for (uint16_t idx = 0; idx < image->frame_count; idx++)
+	{
+		if (!_fits(frames[idx], RES_HORIZ + 1, sizeof(uint16_t), 2, size))
+		{
+			return false;
+		}
+
+		// Offsets must climb so that no column runs backwards or past the end of the frame.
+		const uint16_t * columns = (const uint16_t *)(base + frames[idx]);
+		for (uint8_t column = 0; column < RES_HORIZ; column++)
+		{
+			if ((columns[column] > columns[column + 1]) || ((columns[column + 1] - columns[column]) % 2))
+			{
+				return false;
+			}
+		}
+		if ((columns[0] < (RES_HORIZ + 1) * sizeof(uint16_t)) || (columns[RES_HORIZ] > size - frames[idx]))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+
+
+//======================================================================================================================
+// Library
+//----------------------------------------------------------------------------------------------------------------------
+/* Open the library written to size bytes of flash at base.  Returns false, leaving the library empty, when there is
+ * none or it fails validation.
+ */
+bool library_setup(const uint8_t * base, uint32_t size)
+{
+	const LibraryHeader_t * header = (const LibraryHeader_t *)base;
+	_base = base;
+	_header = NULL;
+
+	if ((header->magic != LIBRARY_MAGIC) || (header->version != LIBRARY_VERSION) || (header->size > size)
+		|| !_fits(sizeof(LibraryHeader_t), header->image_count, sizeof(LibraryImage_t), 4, header->size))
+	{
+		return false;
+	}
+
+	const LibraryImage_t * images = (const LibraryImage_t *)(base + sizeof(LibraryHeader_t));
+	for (uint16_t idx = 0; idx < header->image_count; idx++)
+	{
+		if (!_valid_image(base, &images[idx], header->size))
+		{
+			return false;
+		}
+	}
+
+	_header = header;
+	return true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+uint16_t library_count(void)
+{
+	return _header ? _header->image_count : 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+const LibraryImage_t * library_image(uint16_t index)
+{
+	if (index >= library_count())
+	{
+		return NULL;
+	}
+	return &((const LibraryImage_t *)(_base + sizeof(LibraryHeader_t)))[index];
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Look an image up by name, which need not be NUL terminated.  Returns NULL if there is no such image. */
+const LibraryImage_t * library_find(const char * name, size_t length)
+{
+	if ((length == 0) || (length > LIBRARY_NAME_SIZE))
+	{
+		return NULL;
+	}
+
+	for (uint16_t idx = 0; idx < library_count(); idx++)
+	{
+		const LibraryImage_t * image = library_image(idx);
+		if (!strncmp(image->name, name, length) && ((length == LIBRARY_NAME_SIZE) || !image->name[length]))
+		{
+			return image;
+		}
+	}
+	return NULL;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+const uint32_t * library_colors(const LibraryImage_t * image)
+{
+	return (const uint32_t *)(_base + image->colors);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Locate a frame of an image, for library_column().  Frame numbers past the end wrap around. */
+const uint8_t * library_frame(const LibraryImage_t * image, uint16_t frame)
+{
+	const uint32_t * frames = (const uint32_t *)(_base + image->frames);
+	return _base + frames[frame % image->frame_count];
+}
+
+
+
+
+/* End of File */
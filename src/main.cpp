@@ -27,22 +27,21 @@
 
 #include "pico/stdlib.h"
 #include "hardware/dma.h"
+#include "hardware/flash.h"
 #include "hardware/pio.h"
 #include "apa102.pio.h"
 
+#include "animation.h"
 #include "constants.h"
+#include "frame.h"
 #include "images.h"
+#include "library.h"
 #include "pins.h"
+#include "push.h"
+#include "renderer.h"
 #include "rtt.h"
-
-
-
-
-//======================================================================================================================
-// Data Types
-//----------------------------------------------------------------------------------------------------------------------
-typedef uint32_t Frame_t[RES_HORIZ][RES_VERT];
-
+#include "session.h"
+#include "stream.h"
 
 
 
@@ -55,6 +54,7 @@ char pass[] = "";
 char host[] = "starmap.generationnextcoding.com";
 int port = 80;
 char url[] = "/compasseval.php";
+char push_path[] = "/compassevents";
 
 
 
@@ -62,15 +62,14 @@ char url[] = "/compasseval.php";
 //======================================================================================================================
 // Module Variables
 //----------------------------------------------------------------------------------------------------------------------
-static uint32_t column_left_a[COLUMN_BUFFER_SIZE];
-static uint32_t column_left_b[COLUMN_BUFFER_SIZE];
-static uint32_t column_right_a[COLUMN_BUFFER_SIZE];
-static uint32_t column_right_b[COLUMN_BUFFER_SIZE];
-static Frame_t frame_a;
-static Frame_t frame_b;
-static bool use_column_a = true;
-static bool use_frame_a = true;
+static Column_t column_blank;
+#if PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+// Indexed frames are resolved into these as each column comes up, alternating so the last column can still be sending.
+static Column_t column_a[2];
+static Column_t column_b[2];
+#endif
 PIO led_pio = pio1;
+uint8_t led_offset;
 uint8_t led_a_sm;
 uint8_t led_b_sm;
 uint8_t led_a_dma;
@@ -78,95 +77,169 @@ uint8_t led_b_dma;
 
 WiFiClient client;
 HttpClient http = HttpClient(client, host, port);
+WiFiClient push_client;
+WebSocketClient push_socket = WebSocketClient(push_client, host, port);
+static uint8_t response[RESPONSE_BUFFER_SIZE];
+static uint8_t message[RESPONSE_BUFFER_SIZE];
+// Hash of the region flags last fetched, valid while they are what is shown.
+static uint32_t fetched_hash;
+static bool fetched;
 
 
 
 //======================================================================================================================
 // Helpers
 //----------------------------------------------------------------------------------------------------------------------
-uint32_t __time_critical_func(convert_rgb_to_apa102)(uint32_t value)
+/* Emit the start frame for the next column on both strips.  apa102_mini frames carry their own so this is only
+ * needed for apa102_rgb555.
+ */
+static inline void start_frame(void)
 {
-	uint8_t red = (value >> 16) & 0xFF;
-	uint8_t green = (value >> 8) & 0xFF;
-	uint8_t blue = value & 0xFF;
+#if PIXEL_FORMAT == PIXEL_FORMAT_RGB555
+	apa102_rgb555_start_frame(led_pio, led_a_sm, led_offset);
+	apa102_rgb555_start_frame(led_pio, led_b_sm, led_offset);
+#endif
+}
 
-	uint32_t apa102 = 0x7 << 29
-		| (BRIGHTNESS & 0x1f) << 24
-		| (uint32_t) blue << 16
-		| (uint32_t) green << 8
-		| (uint32_t) red << 0;
 
-	return apa102;
+#if PIXEL_FORMAT == PIXEL_FORMAT_RGB555
+//----------------------------------------------------------------------------------------------------------------------
+/* Program the global brightness (0->31) into both LED state machines. */
+static void set_brightness(uint8_t brightness)
+{
+	apa102_rgb555_set_brightness(led_pio, led_a_sm, brightness & 0x1F);
+	apa102_rgb555_set_brightness(led_pio, led_b_sm, brightness & 0x1F);
 }
+#endif
 
 
 //----------------------------------------------------------------------------------------------------------------------
-static void clear(Frame_t * frame)
+/* Return how far the image has turned, in 1/(1 << RTT_PHASE_SHIFT) columns.  It slowly rotates one column every
+ * ROTATION_TIME, moving on by a fraction of a column whenever it is asked rather than a whole column at a time.
+ */
+static uint32_t rotation(void)
 {
-	for (uint8_t column = 0; column < RES_HORIZ; column++)
+	static uint32_t offset = 60 << RTT_PHASE_SHIFT;
+	static uint32_t previous_rotation = 0;
+
+	uint32_t elapsed = millis() - previous_rotation;
+	uint32_t columns = elapsed / ROTATION_TIME;
+	previous_rotation += columns * ROTATION_TIME;
+	offset = (offset + (columns << RTT_PHASE_SHIFT)) % (RES_HORIZ << RTT_PHASE_SHIFT);
+
+	uint32_t fraction = ((elapsed - columns * ROTATION_TIME) << RTT_PHASE_SHIFT) / ROTATION_TIME;
+	return (offset + fraction) % (RES_HORIZ << RTT_PHASE_SHIFT);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* FNV-1a hash of length bytes, to tell whether a fetched body differs from the last without keeping a copy of it. */
+static uint32_t checksum(const uint8_t * data, int length)
+{
+	uint32_t hash = 2166136261u;
+	for (int idx = 0; idx < length; idx++)
 	{
-		for (uint8_t row = 0; row < RES_VERT; row++)
-		{
-			(*frame)[column][row] = 0;
-		}
+		hash = (hash ^ data[idx]) * 16777619u;
 	}
+	return hash;
 }
 
 
 //----------------------------------------------------------------------------------------------------------------------
-static void render(String active_regions)
+/* Show a full set of region flags.  active_regions holds one '1' or '0' flag per region and must be at least
+ * REGION_COUNT bytes long.  Only the columns of regions that changed are redrawn.
+ */
+static void render(const uint8_t * active_regions)
 {
-	// Build into currently unused frame buffer.
-	Frame_t * frame = use_frame_a ? &frame_b : &frame_a;
+	renderer_set_regions(active_regions);
+	renderer_commit();
+}
 
-	clear(frame);
 
-	for (uint8_t idx = 0; idx < REGION_COUNT; idx++)
+//----------------------------------------------------------------------------------------------------------------------
+static void render(String active_regions)
+{
+	if (active_regions.length() >= REGION_COUNT)
 	{
-		const Region_t * region = Regions[idx];
+		render((const uint8_t *)active_regions.c_str());
+	}
+}
 
-		bool is_active = active_regions[idx] == '1';
-		uint32_t color = is_active ? ColorMap[idx] : INACTIVE_COLOR;
 
+//----------------------------------------------------------------------------------------------------------------------
+/* Apply a pushed message.  It is either a full set of region flags, as returned by polling, or a list of deltas each
+ * made of '+' or '-' and the region number as a hex digit, e.g. "+3-a" to turn region 3 on and region 10 off.  An '@'
+ * followed by a name switches to that image or animation from the flash library, a bare '@' or an unknown name back
+ * to the built-in regions.
+ */
+static void update(const uint8_t * message, int length)
+{
+	if (message[0] == '@')
+	{
+		animation_play(library_find((const char *)message + 1, length - 1));
+		return;
+	}
+
+	// The regions move on from the last fetch, so the next one has to be shown whatever it holds.
+	fetched = false;
+	session_forget();
 
-		for (uint8_t column = 0; column < REGION_WIDTH; column++)
+	if ((message[0] != '+') && (message[0] != '-'))
+	{
+		if (length >= REGION_COUNT)
 		{
-			for (uint8_t row = 0; row < REGION_HEIGHT; row++)
-			{
-				uint8_t byte = row / 8;
-				uint8_t bit = row % 8;
-				uint8_t mask = 1 << (7 - bit);
-				if ((*region)[column][byte] & mask)
-				{
-					(*frame)[column + REGION_OFFSET_X][row + REGION_OFFSET_Y] |= color;
-				}
-			}
+			render(message);
 		}
+		return;
 	}
 
-	// Swap frame buffers.
-	use_frame_a = !use_frame_a;
+	for (int idx = 0; idx + 1 < length; idx += 2)
+	{
+		char digit = message[idx + 1];
+		if (!isxdigit(digit))
+		{
+			break;
+		}
+
+		uint8_t region = (digit <= '9') ? (digit - '0') : ((digit | 0x20) - 'a' + 10);
+		renderer_set_region(region, message[idx] == '+');
+	}
+	renderer_commit();
 }
 
 
 //----------------------------------------------------------------------------------------------------------------------
+/* Start fetching the full set of region flags, unless a fetch is already under way. */
 static void refresh(void)
 {
-	if (WiFi.status() == WL_CONNECTED)
+	if ((WiFi.status() == WL_CONNECTED) && !session_busy())
 	{
-		http.get(url);
-		int statusCode = http.responseStatusCode();
+		// The session keeps the connection open between refreshes and reads the body straight off the socket.
+		session_begin(url, response, sizeof(response));
+	}
+}
 
-		if (statusCode == 200)
-		{
-			String response = http.responseBody();
-			if (response.length() >= 16)
-			{
-				render(response);
-			}
-		}
 
-		http.stop();
+//----------------------------------------------------------------------------------------------------------------------
+/* Show the region flags once a refresh has arrived.  Returns at once if it is still on its way.
+ *
+ * In the steady state nothing changes between refreshes: the server answers 304 with no body, or failing that sends the
+ * same body again, and either way there is nothing to render.
+ */
+static void collect(void)
+{
+	int length;
+	if (!session_busy() || (session_poll(&length) != 200) || (length < REGION_COUNT))
+	{
+		return;
+	}
+
+	uint32_t hash = checksum(response, length);
+	if (!fetched || (hash != fetched_hash))
+	{
+		render(response);
+		fetched_hash = hash;
+		fetched = true;
 	}
 }
 
@@ -184,11 +257,20 @@ void setup1(void)
 	// while (!Serial && ((millis() - timeoutStart) < 5000));
 	// delay(2000);
 
-	uint8_t offset = pio_add_program(led_pio, &apa102_mini_program);
+#if PIXEL_FORMAT == PIXEL_FORMAT_RGB555
+	led_offset = pio_add_program(led_pio, &apa102_rgb555_program);
+	led_a_sm = pio_claim_unused_sm(led_pio, true);
+	apa102_rgb555_program_init(led_pio, led_a_sm, led_offset, SERIAL_FREQ, PIN_CLK_A, PIN_DATA_A);
+	led_b_sm = pio_claim_unused_sm(led_pio, true);
+	apa102_rgb555_program_init(led_pio, led_b_sm, led_offset, SERIAL_FREQ, PIN_CLK_B, PIN_DATA_B);
+	set_brightness(BRIGHTNESS);
+#else
+	led_offset = pio_add_program(led_pio, &apa102_mini_program);
 	led_a_sm = pio_claim_unused_sm(led_pio, true);
-	apa102_mini_program_init(led_pio, led_a_sm, offset, SERIAL_FREQ, PIN_CLK_A, PIN_DATA_A);
+	apa102_mini_program_init(led_pio, led_a_sm, led_offset, SERIAL_FREQ, PIN_CLK_A, PIN_DATA_A);
 	led_b_sm = pio_claim_unused_sm(led_pio, true);
-	apa102_mini_program_init(led_pio, led_b_sm, offset, SERIAL_FREQ, PIN_CLK_B, PIN_DATA_B);
+	apa102_mini_program_init(led_pio, led_b_sm, led_offset, SERIAL_FREQ, PIN_CLK_B, PIN_DATA_B);
+#endif
 
 	// Setup DMA to load LED PIO outputs from RAM buffers.
 	led_a_dma = dma_claim_unused_channel(true);
@@ -196,25 +278,32 @@ void setup1(void)
 	channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
 	channel_config_set_read_increment(&config, true);
 	channel_config_set_write_increment(&config, false);
-	channel_config_set_dreq(&config, pio_get_dreq(led_pio, led_a_dma, true));
-	dma_channel_configure(led_a_dma, &config, &led_pio->txf[led_a_dma], column_left_a, COLUMN_BUFFER_SIZE, false);
+	channel_config_set_dreq(&config, pio_get_dreq(led_pio, led_a_sm, true));
+	dma_channel_configure(led_a_dma, &config, &led_pio->txf[led_a_sm], column_blank, COLUMN_WORDS, false);
 
 	led_b_dma = dma_claim_unused_channel(true);
 	config = dma_channel_get_default_config(led_b_dma);
 	channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
 	channel_config_set_read_increment(&config, true);
 	channel_config_set_write_increment(&config, false);
-	channel_config_set_dreq(&config, pio_get_dreq(led_pio, led_b_dma, true));
-	dma_channel_configure(led_b_dma, &config, &led_pio->txf[led_b_dma], column_right_a, COLUMN_BUFFER_SIZE, false);
-
-	column_left_a[0] = 0;
-	column_left_a[COLUMN_BUFFER_SIZE - 1] = ~0;
-	column_left_b[0] = 0;
-	column_left_b[COLUMN_BUFFER_SIZE - 1] = ~0;
-	column_right_a[0] = 0;
-	column_right_a[COLUMN_BUFFER_SIZE - 1] = ~0;
-	column_right_b[0] = 0;
-	column_right_b[COLUMN_BUFFER_SIZE - 1] = ~0;
+	channel_config_set_dreq(&config, pio_get_dreq(led_pio, led_b_sm, true));
+	dma_channel_configure(led_b_dma, &config, &led_pio->txf[led_b_sm], column_blank, COLUMN_WORDS, false);
+
+	frame_clear_column(&column_blank);
+	library_setup((const uint8_t *)(XIP_BASE + LIBRARY_FLASH_OFFSET), LIBRARY_FLASH_SIZE);
+#if PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+	for (uint8_t idx = 0; idx < 2; idx++)
+	{
+		frame_clear_column(&column_a[idx]);
+		frame_clear_column(&column_b[idx]);
+	}
+#endif
+	renderer_setup();
+
+#if COLUMN_OUTPUT == COLUMN_OUTPUT_STREAMED
+	stream_setup(led_pio, led_a_dma, led_b_dma, &column_blank);
+	rtt_set_index_callback(stream_index);
+#endif
 
 	render(String("1111111111111111"));
 	rtt_setup();
@@ -222,6 +311,8 @@ void setup1(void)
 
 void setup(void)
 {
+	session_setup(&http);
+	push_setup(&push_socket, push_path);
 	WiFi.begin(ssid, pass);
 }
 
@@ -233,92 +324,161 @@ void setup(void)
 //----------------------------------------------------------------------------------------------------------------------
 void __time_critical_func(loop1)(void)
 {
-	static uint8_t previous_column = -1;
-	static uint32_t offset = 60;
-	static uint32_t previous_rotation = 0;
 	static bool running = false;
 
 	if (rtt_rotating())
 	{
-		uint8_t current_column = rtt_column();
+#if COLUMN_OUTPUT == COLUMN_OUTPUT_STREAMED
+		static const Frame_t * streamed_frame = NULL;
+		static uint32_t streamed_offset = 0;
+
+		if (!running)
+		{
+			stream_start();
+		}
 		running = true;
 
-		if (current_column != previous_column)
+		// The pacer and DMA chain handle every column, just keep the address lists in step with the frame and offset.
+		// Once the last lists were taken up at an index pulse the frame before them is no longer sent, and the next
+		// frame and rotation can be queued for the following revolution.
+		if (!stream_pending())
 		{
-			previous_column = current_column;
+			renderer_release();
+			const Frame_t * frame = renderer_acquire();
+			uint32_t offset = rotation();
+			if ((frame != streamed_frame) || (offset != streamed_offset))
+			{
+				streamed_frame = frame;
+				streamed_offset = offset;
+				stream_set_frame(frame, offset);
+			}
+		}
+#else
+		static uint32_t previous_revolution = 0;
+		static uint8_t previous_column = -1;
+		static const Frame_t * frame = NULL;
+		static uint32_t offset = 0;
+		static bool retired = false;
+		running = true;
 
-			// Add the offset to slowly rotate the image.
-			current_column = ((uint32_t)current_column + offset) % RES_HORIZ;
+		uint32_t revolution = rtt_revolution();
+		if ((revolution != previous_revolution) || !frame)
+		{
+			// Latch the frame and the rotation at the index pulse so each revolution is drawn whole from one of each,
+			// with no seam partway round.
+			previous_revolution = revolution;
+			const Frame_t * latched = renderer_acquire();
+			offset = rotation();
+			if (latched != frame)
+			{
+				// Resend the column under the strip from the new frame.
+				frame = latched;
+				previous_column = -1;
+				retired = true;
+			}
+		}
 
-			// Trigger DMA to run output.
-			dma_channel_set_read_addr(led_a_dma, use_column_a ? column_left_a : column_left_b, false);
-			dma_channel_set_read_addr(led_b_dma, use_column_a ? column_right_a : column_right_b, false);
-			dma_channel_set_trans_count(led_a_dma, COLUMN_BUFFER_SIZE, true);
-			dma_channel_set_trans_count(led_b_dma, COLUMN_BUFFER_SIZE, true);
+		// With the rotation turned by a fraction of a column the last column of the old frame starts only just before
+		// the index pulse, so the LED DMA may still be reading it.  It goes back to the renderer once both channels are
+		// done, by which time every column armed since came from the new frame.
+		if (retired && !dma_channel_is_busy(led_a_dma) && !dma_channel_is_busy(led_b_dma))
+		{
+			renderer_release();
+			retired = false;
+		}
 
-			// Swap Buffers
-			use_column_a = !use_column_a;
+		// Adding the offset to the phase, rather than to the column, turns the image by fractions of a column: every
+		// column comes up that much earlier.
+		uint8_t current_column = ((rtt_phase() + offset) >> RTT_PHASE_SHIFT) % RES_HORIZ;
 
-			uint8_t opposite_column = (uint8_t)(((uint16_t)current_column + (RES_HORIZ / 2)) % RES_HORIZ);
+		if (current_column != previous_column)
+		{
+			previous_column = current_column;
 
-			Frame_t * frame = use_frame_a ? &frame_a : &frame_b;
+			uint8_t opposite_column = (uint8_t)(((uint16_t)current_column + (RES_HORIZ / 2)) % RES_HORIZ);
 
-			// Rebuild the next buffer for the next loop.
-			for (int idx = 0; idx < LED_COUNT; idx++)
-			{
-				uint32_t left = (*frame)[current_column][idx * 2 + 1];
-				uint32_t right = (*frame)[opposite_column][idx * 2];
-				left = convert_rgb_to_apa102(left);
-				right = convert_rgb_to_apa102(right);
-				if (use_column_a)
-				{
-					column_left_a[LED_COUNT - idx] = left;
-					column_right_a[LED_COUNT - idx] = right;
-				}
-				else
-				{
-					column_left_b[LED_COUNT - idx] = left;
-					column_right_b[LED_COUNT - idx] = right;
-				}
-			}
+#if PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+			// Colors are looked up as late as possible so a palette change shows on the very next column.
+			static uint8_t buffer = 0;
+			buffer ^= 1;
+			const uint32_t * palette = renderer_palette();
+			frame_resolve_column(&frame->left[current_column], palette, &column_a[buffer]);
+			frame_resolve_column(&frame->right[opposite_column], palette, &column_b[buffer]);
+			const uint32_t * left = column_a[buffer];
+			const uint32_t * right = column_b[buffer];
+#else
+			// Frames are already in output format so just point the DMA at the columns.
+			const uint32_t * left = frame->left[current_column];
+			const uint32_t * right = frame->right[opposite_column];
+#endif
+
+			start_frame();
+			dma_channel_set_read_addr(led_a_dma, left, false);
+			dma_channel_set_read_addr(led_b_dma, right, false);
+			dma_channel_set_trans_count(led_a_dma, COLUMN_WORDS, true);
+			dma_channel_set_trans_count(led_b_dma, COLUMN_WORDS, true);
 		}
+#endif
 	}
 	else
 	{
 		if (running)
 		{
 			running = false;
+#if COLUMN_OUTPUT == COLUMN_OUTPUT_STREAMED
+			stream_stop();
+#endif
 			while (dma_channel_is_busy(led_a_dma) || dma_channel_is_busy(led_b_dma));
 
+			// Nothing reads the frames while stopped, so a frame still retired can go back to the renderer.
+			renderer_release();
+
 			// Go black when not rotating.
-			for (int idx = 0; idx < LED_COUNT; idx++)
-			{
-				column_left_a[idx + 1] = convert_rgb_to_apa102(0);
-				column_right_a[idx + 1] = convert_rgb_to_apa102(0);
-			}
-			dma_channel_set_read_addr(led_a_dma, column_left_a, false);
-			dma_channel_set_read_addr(led_b_dma, column_right_a, false);
-			dma_channel_set_trans_count(led_a_dma, COLUMN_BUFFER_SIZE, true);
-			dma_channel_set_trans_count(led_b_dma, COLUMN_BUFFER_SIZE, true);
+			start_frame();
+			dma_channel_set_read_addr(led_a_dma, column_blank, false);
+			dma_channel_set_read_addr(led_b_dma, column_blank, false);
+			dma_channel_set_trans_count(led_a_dma, COLUMN_WORDS, true);
+			dma_channel_set_trans_count(led_b_dma, COLUMN_WORDS, true);
 		}
 	}
-
-	uint32_t elapsed = millis() - previous_rotation;
-	if (elapsed > ROTATION_TIME)
-	{
-		previous_rotation += ROTATION_TIME;
-		offset++;
-		// digitalWrite(LED_BUILTIN, !digitalRead(LED_BUILTIN));
-	}
 }
 
 
 void __time_critical_func(loop)(void)
 {
 	static uint32_t previous_refresh = 0;
+	static bool was_pushing = false;
+
+	animation_service();
+	// Sends anything a commit had to put off while the output core held the buffers.
+	renderer_commit();
+
+	if (WiFi.status() != WL_CONNECTED)
+	{
+		return;
+	}
+
+	// A refresh is taken in as it arrives, the loop keeps turning while it is on its way.
+	collect();
+
+	// While the push channel is up the server sends region changes as they happen, polling only covers for it being
+	// down.
+	int length = push_poll(message, sizeof(message));
+	if (length > 0)
+	{
+		update(message, length);
+	}
+
+	bool pushing = push_connected();
+	if (pushing && !was_pushing)
+	{
+		// Catch up on anything that changed while the socket was down.
+		refresh();
+	}
+	was_pushing = pushing;
 
 	uint32_t elapsed = millis() - previous_refresh;
-	if (elapsed > REFRESH_TIME)
+	if (!pushing && (elapsed > REFRESH_TIME))
 	{
 		refresh();
 		previous_refresh = millis();
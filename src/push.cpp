@@ -0,0 +1,195 @@
+/* =====================================================================================================================
+ *      File:  /src/push.cpp
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "constants.h"
+#include "push.h"
+
+
+
+
+//======================================================================================================================
+// Module Variables
+//----------------------------------------------------------------------------------------------------------------------
+static WebSocketClient * _socket;
+static const char * _path;
+static bool _connected;
+static bool _attempted;
+static uint32_t _last_attempt;
+static uint32_t _last_ping;
+
+// The message being taken in, while _remaining.
+static int _remaining;
+static int _received;
+static uint32_t _last_data;
+
+
+
+
+//======================================================================================================================
+// Helpers
+//----------------------------------------------------------------------------------------------------------------------
+static void _disconnect(void)
+{
+	_socket->stop();
+	_connected = false;
+	_remaining = 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Open the socket if it is time for another attempt. */
+static void _connect(void)
+{
+	uint32_t now = millis();
+	if (_attempted && ((now - _last_attempt) < PUSH_RETRY_TIME))
+	{
+		return;
+	}
+	_attempted = true;
+	_last_attempt = now;
+
+	// HttpClient puts its timeouts back to the defaults whenever it is stopped.
+	_socket->setHttpResponseTimeout(PUSH_CONNECT_TIMEOUT);
+	if (_socket->begin(_path) == 0)
+	{
+		_connected = true;
+		_last_ping = now;
+	}
+	else
+	{
+		_socket->stop();
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Take in whatever has arrived of the message in progress and return straight away.
+ *
+ * Returns the number of bytes stored once all of it is in, 0 while some of it is still to come, or -1 if it has stalled
+ * for longer than PUSH_CONNECT_TIMEOUT.
+ */
+static int _read_message(uint8_t * message, size_t size)
+{
+	while (_remaining > 0)
+	{
+		// Anything beyond the end of the buffer is read and dropped so the stream stays in step with the framing.
+		uint8_t discard[16];
+		uint8_t * target = ((size_t)_received < size) ? message + _received : discard;
+		size_t space = ((size_t)_received < size) ? size - _received : sizeof(discard);
+
+		int count = _socket->read(target, min(space, (size_t)_remaining));
+		if (count <= 0)
+		{
+			return ((millis() - _last_data) < PUSH_CONNECT_TIMEOUT) ? 0 : -1;
+		}
+		_remaining -= count;
+		_received += count;
+		_last_data = millis();
+	}
+
+	return min(_received, (int)size);
+}
+
+
+
+
+//======================================================================================================================
+// Push Channel
+//----------------------------------------------------------------------------------------------------------------------
+/* Subscribe to updates pushed by the server over a WebSocket at path on the socket's host. */
+void push_setup(WebSocketClient * socket, const char * path)
+{
+	_socket = socket;
+	_path = path;
+	_connected = false;
+	_attempted = false;
+	_remaining = 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Service the socket, (re)connecting as needed, and collect the next pushed message.
+ *
+ * Returns the number of bytes of the message stored in message, truncated to size, or 0 until a whole message has
+ * arrived.  A message is taken in across calls as it arrives, so the same buffer must be passed each time.
+ * Control frames are answered inside WebSocketClient and never returned.  A periodic ping makes sure a connection the
+ * server has silently dropped is noticed.
+ */
+int push_poll(uint8_t * message, size_t size)
+{
+	if (!_connected)
+	{
+		_connect();
+		return 0;
+	}
+
+	if (!_socket->connected())
+	{
+		_disconnect();
+		return 0;
+	}
+
+	uint32_t now = millis();
+	if ((now - _last_ping) > PUSH_PING_TIME)
+	{
+		_last_ping = now;
+		if (_socket->ping() != 0)
+		{
+			_disconnect();
+			return 0;
+		}
+	}
+
+	if (_remaining == 0)
+	{
+		int length = _socket->parseMessage();
+		if (length <= 0)
+		{
+			return 0;
+		}
+		_remaining = length;
+		_received = 0;
+		_last_data = now;
+	}
+
+	int stored = _read_message(message, size);
+	if (stored < 0)
+	{
+		_disconnect();
+		return 0;
+	}
+
+	return stored;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+bool push_connected(void)
+{
+	return _connected;
+}
+
+
+
+
+/* End of File */
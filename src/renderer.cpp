@@ -0,0 +1,548 @@
+/* =====================================================================================================================
+ *      File:  /src/renderer.cpp
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "hardware/sync.h"
+
+#include "constants.h"
+#include "images.h"
+#include "library.h"
+#include "renderer.h"
+
+
+
+
+//======================================================================================================================
+// Definitions
+//----------------------------------------------------------------------------------------------------------------------
+#define DIRTY_WORDS ((RES_HORIZ + 31) / 32)
+#define FRAME_BUFFERS 3
+#define NO_BUFFER FRAME_BUFFERS
+
+// APA102 frames are the largest, three of them take more than half of the RP2040's 264 KB of SRAM.  Whatever they leave
+// has to hold the stacks of both cores, the heap and the WiFi stack.
+#define SRAM_SIZE (264 * 1024)
+#define SRAM_RESERVED (96 * 1024)
+static_assert(sizeof(Frame_t) * FRAME_BUFFERS <= SRAM_SIZE - SRAM_RESERVED, "Frame buffers leave too little SRAM");
+
+
+
+
+//======================================================================================================================
+// Module Variables
+//----------------------------------------------------------------------------------------------------------------------
+// Triple buffered so neither core ever waits on the other.  Core 0 draws into whichever buffer is neither the newest
+// published one nor one the output core holds, while the output core takes the newest at the start of a revolution.
+// Each index has a single writer: _latest is only written by the renderer, _showing and _retired only by the output
+// core.  _retired is a frame the output core has moved on from but may still be sending, until it releases it.
+static Frame_t _frames[FRAME_BUFFERS];
+static uint32_t _sequences[FRAME_BUFFERS];
+static volatile uint8_t _latest;
+static volatile uint8_t _showing;
+static volatile uint8_t _retired;
+static bool _changed;
+static bool _deferring;
+static RendererStats_t _stats;
+
+static bool _active[REGION_COUNT];
+
+// Library image frame being drawn, or NULL for the built-in regions, and the colors of its labels.
+static const uint8_t * _image_frame;
+static const uint32_t * _colors;
+static uint8_t _color_count;
+
+// Output format pixel for each label, label 0 being the background.  Labels up to REGION_COUNT belong to regions and
+// show INACTIVE_COLOR until activated.
+static uint32_t _palette[PALETTE_SIZE];
+
+#if PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+// Indexed frames hold labels, which the output core resolves through this copy of the palette as each column is sent.
+static uint32_t _published[PALETTE_SIZE];
+static bool _recolored;
+#endif
+
+// Columns each buffer still has to redraw.  A change has to reach every buffer by the time it is next drawn into, so
+// every change is marked in all of them.
+static uint32_t _dirty[FRAME_BUFFERS][DIRTY_WORDS];
+
+
+
+
+//======================================================================================================================
+// Helpers
+//----------------------------------------------------------------------------------------------------------------------
+static inline void _mark(uint8_t column)
+{
+	for (uint8_t buffer = 0; buffer < FRAME_BUFFERS; buffer++)
+	{
+		_dirty[buffer][column / 32] |= 1u << (column % 32);
+	}
+	_changed = true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Value a label is drawn with.  Indexed frames keep the label itself so recoloring a region never needs a redraw. */
+static inline uint32_t _pixel(uint8_t label)
+{
+#if PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+	return label;
+#else
+	return _palette[label];
+#endif
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+static inline void _update_palette(uint8_t region)
+{
+	if (region < _color_count)
+	{
+		_palette[region + 1] = frame_convert(_active[region] ? _colors[region] : INACTIVE_COLOR);
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Rebuild the whole palette for a new set of colors, leaving any labels past the last color as background. */
+static void _load_palette(const uint32_t * colors, uint8_t count)
+{
+	_colors = colors;
+	_color_count = count;
+
+	_palette[0] = frame_convert(0);
+	for (uint8_t label = 1; label < PALETTE_SIZE; label++)
+	{
+		_palette[label] = (label <= count) ? frame_convert(colors[label - 1]) : _palette[0];
+	}
+	for (uint8_t region = 0; region < REGION_COUNT; region++)
+	{
+		_update_palette(region);
+	}
+
+#if PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+	_recolored = true;
+#endif
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Hand any palette changes to the output core.  Each entry is a single word store, so a column sent part way through
+ * can only mix the old and new colors of different regions, never tear a color.
+ */
+static inline bool _publish_palette(void)
+{
+#if PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+	if (!_recolored)
+	{
+		return false;
+	}
+
+	_recolored = false;
+	for (uint8_t idx = 0; idx < PALETTE_SIZE; idx++)
+	{
+		_published[idx] = _palette[idx];
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+#if IMAGE_FORMAT == IMAGE_FORMAT_LABELS
+/* Draw one column of the built-in regions, looking each pixel's region up in the label map. */
+static void _draw_regions(Frame_t * frame, uint8_t column)
+{
+	if ((column < REGION_OFFSET_X) || (column >= REGION_OFFSET_X + REGION_WIDTH))
+	{
+		return;
+	}
+
+	const uint8_t * labels = LabelMap[column - REGION_OFFSET_X];
+	for (uint8_t row = 0; row < REGION_HEIGHT; row++)
+	{
+		if (labels[row])
+		{
+			frame_merge(frame, column, row + REGION_OFFSET_Y, _pixel(labels[row]));
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Dirty the columns a region covers. */
+static inline void _invalidate_region(uint8_t region)
+{
+	renderer_invalidate(RegionExtents[region].first_column + REGION_OFFSET_X, RegionExtents[region].column_count);
+}
+#else
+/* Draw one column of the built-in regions, filling each region's spans whether it is active or not. */
+static void _draw_regions(Frame_t * frame, uint8_t column)
+{
+	if ((column < REGION_OFFSET_X) || (column >= REGION_OFFSET_X + REGION_WIDTH))
+	{
+		return;
+	}
+	uint8_t region_column = column - REGION_OFFSET_X;
+
+	for (uint8_t idx = 0; idx < REGION_COUNT; idx++)
+	{
+		const RegionSpans_t * region = &RegionSpans[idx];
+		uint8_t entry = region_column - region->first_column;
+		if ((region_column < region->first_column) || (entry >= region->column_count))
+		{
+			continue;
+		}
+
+		uint32_t pixel = _pixel(idx + 1);
+		for (uint16_t span = region->index[entry]; span < region->index[entry + 1]; span++)
+		{
+			const Span_t * run = &region->spans[span];
+			frame_fill_span(frame, column, run->row + REGION_OFFSET_Y, run->length, pixel);
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Dirty the columns a region covers. */
+static inline void _invalidate_region(uint8_t region)
+{
+	renderer_invalidate(RegionSpans[region].first_column + REGION_OFFSET_X, RegionSpans[region].column_count);
+}
+#endif
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Decode one column of the current library image straight into the frame, one span per run. */
+static void _draw_image(Frame_t * frame, uint8_t column)
+{
+	const uint8_t * end;
+	const uint8_t * run = library_column(_image_frame, column, &end);
+
+	for (uint8_t row = 0; run < end; run += 2)
+	{
+		uint8_t length = run[0];
+		uint8_t label = run[1];
+		if (length > RES_VERT - row)
+		{
+			break;
+		}
+
+		if (label && (label < PALETTE_SIZE))
+		{
+			frame_fill_span(frame, column, row, length, _pixel(label));
+		}
+		row += length;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Rebuild one column of a frame from scratch. */
+static void _draw_column(Frame_t * frame, uint8_t column)
+{
+	frame_clear_column(&frame->left[column]);
+	frame_clear_column(&frame->right[column]);
+
+	if (_image_frame)
+	{
+		_draw_image(frame, column);
+	}
+	else
+	{
+		_draw_regions(frame, column);
+	}
+}
+
+
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Pick a buffer to draw the next frame into, or NO_BUFFER if the output core holds all but the newest.
+ *
+ * The output core may take the newest at any moment but never a buffer that wasn't published, so anything other than
+ * that and the ones it holds is free.  _showing is read first: the output core retires the old frame before it shows
+ * the new one, so a frame moving between the two is always seen in one of them.
+ */
+static uint8_t _back_buffer(uint8_t latest)
+{
+	uint8_t showing = _showing;
+	__dmb();
+	uint8_t retired = _retired;
+
+	for (uint8_t buffer = 0; buffer < FRAME_BUFFERS; buffer++)
+	{
+		if ((buffer != latest) && (buffer != showing) && (buffer != retired))
+		{
+			return buffer;
+		}
+	}
+	return NO_BUFFER;
+}
+
+
+
+
+//======================================================================================================================
+// Renderer
+//----------------------------------------------------------------------------------------------------------------------
+/* Start on the built-in regions with every region inactive and all buffers due a full redraw. */
+void renderer_setup(void)
+{
+	_latest = 0;
+	_showing = 0;
+	_retired = NO_BUFFER;
+	_sequences[0] = 0;
+	_deferring = false;
+	_stats = {};
+	_image_frame = NULL;
+	for (uint8_t idx = 0; idx < REGION_COUNT; idx++)
+	{
+		_active[idx] = false;
+	}
+	_load_palette(ColorMap, REGION_COUNT);
+	_publish_palette();
+	renderer_invalidate(0, RES_HORIZ);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Show a frame of a library image in place of the built-in regions, or go back to them if image is NULL.  The region
+ * flags carry over and the image is decoded into the back buffer at the next commit.
+ */
+void renderer_set_image(const LibraryImage_t * image, uint16_t frame)
+{
+	const uint8_t * image_frame = image ? library_frame(image, frame) : NULL;
+	if (image_frame == _image_frame)
+	{
+		return;
+	}
+
+	// The frames of an animation share their colors, so stepping through them leaves the palette alone.
+	const uint32_t * colors = image ? library_colors(image) : ColorMap;
+	if (colors != _colors)
+	{
+		_load_palette(colors, image ? image->color_count : REGION_COUNT);
+	}
+	_image_frame = image_frame;
+	renderer_invalidate(0, RES_HORIZ);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Apply a full set of region flags, one '1' or '0' per region, as a delta against the current state. */
+void renderer_set_regions(const uint8_t * active_regions)
+{
+	for (uint8_t idx = 0; idx < REGION_COUNT; idx++)
+	{
+		renderer_set_region(idx, active_regions[idx] == '1');
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Change one region, dirtying only the columns it covers and only if it actually changed. */
+void renderer_set_region(uint8_t region, bool active)
+{
+	if ((region >= REGION_COUNT) || (_active[region] == active))
+	{
+		return;
+	}
+
+	_active[region] = active;
+	_update_palette(region);
+#if PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+	// The frames only hold the region's label, its new color goes out with the palette at the next commit.
+	_recolored = true;
+#else
+	if (_image_frame)
+	{
+		// There's no record of which columns an image's regions cover.
+		renderer_invalidate(0, RES_HORIZ);
+	}
+	else
+	{
+		_invalidate_region(region);
+	}
+#endif
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Force a range of columns to be redrawn, for changes the renderer can't see for itself. */
+void renderer_invalidate(uint8_t first, uint8_t count)
+{
+	for (uint16_t column = first; (column < first + count) && (column < RES_HORIZ); column++)
+	{
+		_mark(column);
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Redraw the dirty columns of a free buffer and publish it as the newest frame.
+ *
+ * Every buffer's dirty set covers everything since it was last drawn into, so any of them can be brought up to date.
+ * Returns false, publishing nothing, when nothing has changed or when the output core still holds every buffer but the
+ * newest; the changes then go out with a later commit.
+ */
+bool renderer_commit(void)
+{
+	uint8_t latest = _latest;
+	uint8_t back = _changed ? _back_buffer(latest) : NO_BUFFER;
+	bool changed = (back != NO_BUFFER);
+
+	if (_changed && !changed && !_deferring)
+	{
+		// Counted once however many commits it takes the changes to go out.
+		_stats.deferred++;
+		_deferring = true;
+	}
+
+	if (changed)
+	{
+		_changed = false;
+		_deferring = false;
+
+		for (uint8_t word = 0; word < DIRTY_WORDS; word++)
+		{
+			while (_dirty[back][word])
+			{
+				uint8_t bit = __builtin_ctz(_dirty[back][word]);
+				_dirty[back][word] &= ~(1u << bit);
+				_draw_column(&_frames[back], word * 32 + bit);
+			}
+		}
+
+		_stats.published++;
+		_sequences[back] = _stats.published;
+
+		// The frame must be complete in memory before the output core can see it is the newest.
+		__dmb();
+		_latest = back;
+
+		if (_showing != latest)
+		{
+			// Replaced before the output core ever took it.
+			_stats.skipped++;
+		}
+	}
+
+	// Published after the frame so a new image's labels are only briefly shown in the old colors, not for the whole
+	// redraw.
+	bool recolored = _publish_palette();
+	return changed || recolored;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Whether there are changes no commit has published yet, as there are after one was put off until the output core
+ * freed a buffer.
+ */
+bool renderer_pending(void)
+{
+	return _changed;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Move the output on to the newest published frame, returning the frame to show.  Only the output core may call this,
+ * at the start of a revolution so that every revolution shows one whole frame.
+ *
+ * The frame shown until now is retired rather than freed, the renderer leaves it alone until renderer_release().  While
+ * a retired frame is held no newer frame is taken and the current one is returned again.
+ */
+const Frame_t * renderer_acquire(void)
+{
+	uint8_t latest = _latest;
+	uint8_t showing = _showing;
+	if ((latest != showing) && (_retired == NO_BUFFER))
+	{
+		_retired = showing;
+		__dmb();
+
+		// Claim it, then check it is still the newest now the claim is visible.  The renderer never draws into the
+		// newest or a held buffer, so once both agree it is safe; if a newer frame arrived, claim that instead.
+		do
+		{
+			_showing = latest;
+			__dmb();
+			latest = _latest;
+		} while (latest != _showing);
+
+		_stats.shown++;
+	}
+
+	return &_frames[_showing];
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Hand the retired frame back to the renderer once nothing reads it any more.  Only the output core may call this. */
+void renderer_release(void)
+{
+	__dmb();
+	_retired = NO_BUFFER;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* The frame the output core is showing.  Only the output core may call this. */
+const Frame_t * renderer_frame(void)
+{
+	return &_frames[_showing];
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Sequence number of the frame the output core is showing, counting every frame published.  Gaps between the frames
+ * shown are frames that were replaced before a revolution started.  Only the output core may call this.
+ */
+uint32_t renderer_sequence(void)
+{
+	return _sequences[_showing];
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+const RendererStats_t * renderer_stats(void)
+{
+	return &_stats;
+}
+
+
+#if PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+//----------------------------------------------------------------------------------------------------------------------
+/* APA102 word for each index in the frames, as of the last commit. */
+const uint32_t * renderer_palette(void)
+{
+	return _published;
+}
+#endif
+
+
+
+
+/* End of File */
@@ -21,6 +21,8 @@
 // =====================================================================================================================
 // Includes
 // ---------------------------------------------------------------------------------------------------------------------
+#include "hardware/sync.h"
+
 #include "constants.h"
 #include "pins.h"
 #include "rtt.h"
@@ -28,15 +30,95 @@
 
 
 
-#define ROTATIONS 32
+//======================================================================================================================
+// Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Alpha-beta filter gains as shifts: alpha = 1/4 on the period, beta = 1/16 on the per-revolution period change.
+#define FILTER_ALPHA_SHIFT 2
+#define FILTER_BETA_SHIFT 4
+
+// Revolutions slower than this are treated as stopped.
+#define MAX_PERIOD_US 100000
+
+// Pulses closer together than this can't be a revolution, well beyond the fastest the globe is ever spun.
+#define MIN_PERIOD_US 5000
+
+// Phase is computed as elapsed * scale >> SCALE_SHIFT.
+#define SCALE_SHIFT 16
+
+enum
+{
+	STATE_IDLE,
+	STATE_INDEXED,
+	STATE_TRACKING,
+};
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Everything the readers need, published together by the IRQ.
+typedef struct
+{
+	bool tracking;
+	uint32_t revolution;
+	uint32_t last_event;
+	uint32_t predicted;
+	uint32_t scale;
+} Snapshot_t;
+
+
+
 
 //======================================================================================================================
 // Module Variables
 //----------------------------------------------------------------------------------------------------------------------
-static critical_section_t _critical_section;
-static uint32_t _deltas[ROTATIONS];
-static uint8_t _head;
-static absolute_time_t _last_event;
+// Filter state, only touched by the IRQ.
+static uint8_t _state;
+static uint32_t _last_event;
+static uint32_t _period;
+static int32_t _rate;
+static uint32_t _predicted;
+static uint32_t _revolution;
+
+// Published state.  _sequence is odd while the IRQ is writing _snapshot.
+static volatile uint32_t _sequence;
+static Snapshot_t _snapshot;
+
+static rtt_index_callback_t _index_callback;
+
+
+
+
+//======================================================================================================================
+// Helpers
+//----------------------------------------------------------------------------------------------------------------------
+/* Publish new timing from the IRQ.  Never waits on a reader. */
+static inline void _publish(const Snapshot_t * snapshot)
+{
+	_sequence = _sequence + 1;
+	__dmb();
+	_snapshot = *snapshot;
+	__dmb();
+	_sequence = _sequence + 1;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Take a consistent copy of the published timing, retrying if the IRQ updated it part way through. */
+static inline void _read(Snapshot_t * snapshot)
+{
+	uint32_t sequence;
+	do
+	{
+		sequence = _sequence;
+		__dmb();
+		*snapshot = _snapshot;
+		__dmb();
+	} while ((sequence & 1) || (sequence != _sequence));
+}
 
 
 
@@ -44,6 +126,12 @@ static absolute_time_t _last_event;
 //======================================================================================================================
 // IRQ Callback
 //----------------------------------------------------------------------------------------------------------------------
+/* Update the rotation estimate at each index pulse.
+ *
+ * An alpha-beta filter tracks the revolution time and its change per revolution, so the prediction for the coming
+ * revolution follows the motor through spin-up and spin-down instead of lagging behind a plain average.  All of the
+ * division happens here, once per revolution, leaving the column lookup a multiply and a shift.
+ */
 static void __time_critical_func(_gpio_hall_sensor_callback)(uint gpio, uint32_t events)
 {
 	if (gpio != PIN_HALL)
@@ -51,31 +139,72 @@ static void __time_critical_func(_gpio_hall_sensor_callback)(uint gpio, uint32_t
 		return;
 	}
 
-	absolute_time_t now = get_absolute_time();
+	uint32_t now = time_us_32();
+	uint32_t delta = now - _last_event;
+	bool stopped = (_state != STATE_TRACKING) || (delta > MAX_PERIOD_US);
+	uint32_t measured = min(delta, (uint32_t)MAX_PERIOD_US) << RTT_PERIOD_SHIFT;
 
-	critical_section_enter_blocking(&_critical_section);
-	if (!is_nil_time(_last_event))
+	// Ignore pulses far too early to be the next revolution, they are switch bounce or noise.
+	if (!stopped && (measured < (_predicted / 2)))
+	{
+		return;
+	}
+	// With no prediction to go on yet only a pulse faster than any real revolution can be ruled out.  That also keeps
+	// the period seeding the filter, and so the division below, from ever being zero.
+	if ((_state != STATE_IDLE) && (delta < MIN_PERIOD_US))
+	{
+		return;
+	}
+
+	uint32_t period = _period;
+	int32_t rate = _rate;
+	if (stopped)
+	{
+		// (Re)seed from a single measurement after a stop or the first pair of pulses.
+		period = measured;
+		rate = 0;
+	}
+	else
 	{
-		_deltas[_head] = absolute_time_diff_us(_last_event, now);
-		_head = (_head + 1) % ROTATIONS;
+		int32_t residual = (int32_t)(measured - _predicted);
+		period = _predicted + (residual >> FILTER_ALPHA_SHIFT);
+		rate = rate + (residual >> FILTER_BETA_SHIFT);
 	}
+
+	uint32_t predicted = (uint32_t)((int32_t)period + rate);
+	if (predicted < (period / 2))
+	{
+		predicted = period / 2;
+	}
+	uint64_t turn = (uint64_t)RES_HORIZ << (RTT_PHASE_SHIFT + SCALE_SHIFT + RTT_PERIOD_SHIFT);
+	uint32_t scale = (uint32_t)(turn / predicted);
+
 	_last_event = now;
-	critical_section_exit(&_critical_section);
-}
+	if (_state == STATE_IDLE)
+	{
+		_state = STATE_INDEXED;
+	}
+	else
+	{
+		_period = period;
+		_rate = rate;
+		_predicted = predicted;
+		_state = STATE_TRACKING;
+		_revolution++;
+	}
 
+	Snapshot_t snapshot;
+	snapshot.tracking = (_state == STATE_TRACKING);
+	snapshot.revolution = _revolution;
+	snapshot.last_event = now;
+	snapshot.predicted = predicted;
+	snapshot.scale = scale;
+	_publish(&snapshot);
 
-//----------------------------------------------------------------------------------------------------------------------
-static uint32_t __time_critical_func(_rev_time)(void)
-{
-	uint32_t sum = 0;
-	critical_section_enter_blocking(&_critical_section);
-	for (uint8_t idx = 0; idx < ROTATIONS; idx++)
+	if (_index_callback && (_state == STATE_TRACKING))
 	{
-		sum += _deltas[idx];
+		_index_callback(predicted >> RTT_PERIOD_SHIFT);
 	}
-	critical_section_exit(&_critical_section);
-	sum /= ROTATIONS;
-	return sum;
 }
 
 
@@ -86,36 +215,104 @@ static uint32_t __time_critical_func(_rev_time)(void)
 //----------------------------------------------------------------------------------------------------------------------
 void rtt_setup(void)
 {
-	_head = 0;
-	_last_event = nil_time;
+	_state = STATE_IDLE;
+	_last_event = 0;
+	_period = 0;
+	_rate = 0;
+	_predicted = 0;
+	_revolution = 0;
 
-	critical_section_init(&_critical_section);
+	Snapshot_t snapshot;
+	snapshot.tracking = false;
+	snapshot.revolution = 0;
+	snapshot.last_event = 0;
+	snapshot.predicted = 0;
+	snapshot.scale = 0;
+	_publish(&snapshot);
 
 	pinMode(PIN_HALL, INPUT_PULLUP);
 	gpio_set_irq_enabled_with_callback(PIN_HALL, GPIO_IRQ_EDGE_FALL, true, _gpio_hall_sensor_callback);
 }
 
 
+//----------------------------------------------------------------------------------------------------------------------
+/* Register a function to be called at the start of every revolution. */
+void rtt_set_index_callback(rtt_index_callback_t callback)
+{
+	_index_callback = callback;
+}
+
+
 
 
 //======================================================================================================================
 // RTT Column Function
+//----------------------------------------------------------------------------------------------------------------------
+/* Return the predicted revolution time in 1/(1 << RTT_PERIOD_SHIFT) microseconds, or zero if not yet known. */
+uint32_t __time_critical_func(rtt_period)(void)
+{
+	Snapshot_t snapshot;
+	_read(&snapshot);
+
+	return snapshot.tracking ? snapshot.predicted : 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Return the current position in 1/(1 << RTT_PHASE_SHIFT) columns, in the range [0, RES_HORIZ << RTT_PHASE_SHIFT). */
+uint32_t __time_critical_func(rtt_phase)(void)
+{
+	Snapshot_t snapshot;
+	_read(&snapshot);
+
+	uint32_t elapsed = time_us_32() - snapshot.last_event;
+	uint32_t phase = (uint32_t)(((uint64_t)elapsed * snapshot.scale) >> SCALE_SHIFT);
+
+	// Hold the last column if the index pulse is late rather than wrapping back around.
+	if (phase >= (RES_HORIZ << RTT_PHASE_SHIFT))
+	{
+		phase = (RES_HORIZ << RTT_PHASE_SHIFT) - 1;
+	}
+
+	return phase;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Return the number of index pulses seen while tracking, which changes exactly when the phase starts again from
+ * zero.
+ */
+uint32_t __time_critical_func(rtt_revolution)(void)
+{
+	Snapshot_t snapshot;
+	_read(&snapshot);
+
+	return snapshot.revolution;
+}
+
+
 //----------------------------------------------------------------------------------------------------------------------
 /* Return the current column index. */
 uint8_t __time_critical_func(rtt_column)(void)
 {
-	absolute_time_t now = get_absolute_time();
-	uint32_t rot_delta = absolute_time_diff_us(_last_event, now);
-	uint8_t column = rot_delta * RES_HORIZ / _rev_time();
-
-	return column % RES_HORIZ;
+	return rtt_phase() >> RTT_PHASE_SHIFT;
 }
 
 
 //----------------------------------------------------------------------------------------------------------------------
+/* Rotating means a revolution time is being tracked, is fast enough, and the next pulse isn't long overdue. */
 bool __time_critical_func(rtt_rotating)(void)
 {
-	return !is_nil_time(_last_event) && (_rev_time() < 100000);
+	Snapshot_t snapshot;
+	_read(&snapshot);
+
+	if (!snapshot.tracking || (snapshot.predicted >= ((uint32_t)MAX_PERIOD_US << RTT_PERIOD_SHIFT)))
+	{
+		return false;
+	}
+
+	uint32_t elapsed = time_us_32() - snapshot.last_event;
+	return elapsed < ((snapshot.predicted * 2) >> RTT_PERIOD_SHIFT);
 }
 
 
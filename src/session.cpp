@@ -0,0 +1,263 @@
+/* =====================================================================================================================
+ *      File:  /src/session.cpp
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "session.h"
+#include "constants.h"
+
+
+
+
+//======================================================================================================================
+// Module Variables
+//----------------------------------------------------------------------------------------------------------------------
+static HttpClient * _http;
+static SessionStats_t _stats;
+
+// The request in flight, if _busy.
+static bool _busy;
+static bool _reused;
+static const char * _path;
+static uint8_t * _body;
+static size_t _size;
+static uint32_t _start;
+
+// Validators from the last full response, sent back so the server can answer 304 if nothing has changed since.
+static HttpHeader _validators[] = {{"ETag", NULL, 0}, {"Last-Modified", NULL, 0}};
+static char _etag[VALIDATOR_SIZE];
+static char _modified[VALIDATOR_SIZE];
+
+
+
+
+//======================================================================================================================
+// Helpers
+//----------------------------------------------------------------------------------------------------------------------
+/* Send the GET, connecting first if need be, made conditional on the validators of the last full response.  Returns
+ * HTTP_SUCCESS or a negative HTTP_ERROR_* code.
+ */
+static int _send(void)
+{
+	if (!_http->connected())
+	{
+		_stats.connects++;
+	}
+
+	_http->beginRequest();
+	int result = _http->get(_path);
+	if (result != HTTP_SUCCESS)
+	{
+		return result;
+	}
+
+	// If-None-Match wins where a server understands both, If-Modified-Since is only for servers that send no ETag.
+	if (_etag[0])
+	{
+		_http->sendHeader("If-None-Match", _etag);
+	}
+	else if (_modified[0])
+	{
+		_http->sendHeader("If-Modified-Since", _modified);
+	}
+	_http->endRequest();
+	return HTTP_SUCCESS;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Copy a captured header value into store, or empty it if the header was missing or is too long to keep. */
+static void _remember(const HttpHeader * header, char * store)
+{
+	size_t length = 0;
+	if (header->value && (header->length < VALIDATOR_SIZE))
+	{
+		length = header->length;
+		memcpy(store, header->value, length);
+	}
+	store[length] = '\0';
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Deal with a request that failed.
+ *
+ * A server is free to drop an idle keep-alive connection, and that is often only discovered when the next request
+ * fails, so a failure on a reused connection is retried once on a new one.  Returns HTTP_PENDING if the retry is under
+ * way, otherwise the error, ending the request.
+ */
+static int _fail(int error)
+{
+	_http->stop();
+
+	if (_reused)
+	{
+		_stats.retries++;
+		_reused = false;
+		int result = _send();
+		if (result == HTTP_SUCCESS)
+		{
+			return HTTP_PENDING;
+		}
+		error = result;
+		_http->stop();
+	}
+
+	_stats.failures++;
+	_busy = false;
+	return error;
+}
+
+
+
+
+//======================================================================================================================
+// Session
+//----------------------------------------------------------------------------------------------------------------------
+/* Use the provided client for all requests, holding its connection open between them. */
+void session_setup(HttpClient * http)
+{
+	_http = http;
+	_http->connectionKeepAlive();
+	_http->watchHeaders(_validators, sizeof(_validators) / sizeof(_validators[0]));
+	_busy = false;
+	session_forget();
+	memset(&_stats, 0, sizeof(_stats));
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Send a GET for path, to be collected with session_poll() into the size bytes at body.
+ *
+ * Only one path is expected to be fetched, the request carries the validators of the last full response to it so an
+ * unchanged body is answered with a bare 304.  The connection is reused when the server kept it open.  Only connecting
+ * can block; the response is never waited for.
+ *
+ * Returns HTTP_SUCCESS once the request is on its way, or a negative HTTP_ERROR_* code.
+ */
+int session_begin(const char * path, uint8_t * body, size_t size)
+{
+	if (_busy)
+	{
+		return HTTP_ERROR_API;
+	}
+
+	_busy = true;
+	_reused = _http->connected();
+	_path = path;
+	_body = body;
+	_size = size;
+	_start = micros();
+
+	int result = _send();
+	if (result != HTTP_SUCCESS)
+	{
+		result = _fail(result);
+	}
+	return (result == HTTP_PENDING) ? HTTP_SUCCESS : result;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Take in whatever has arrived of the response and return straight away.
+ *
+ * Returns HTTP_PENDING until the response is complete, then once its HTTP status code with the length of the body
+ * stored, or a negative HTTP_ERROR_* code.  304 means the body last returned with 200 still stands.
+ */
+int session_poll(int * length)
+{
+	*length = 0;
+	if (!_busy)
+	{
+		return HTTP_ERROR_API;
+	}
+
+	int status = _http->pollResponse(_body, _size, length);
+	if (status == HTTP_PENDING)
+	{
+		return HTTP_PENDING;
+	}
+	if (status < 0)
+	{
+		*length = 0;
+		return _fail(status);
+	}
+
+	// The next request can only share the connection if this body was read to its end.  Anything left over, or a body
+	// delimited by the server closing, means starting afresh.
+	if (!_http->endOfBodyReached())
+	{
+		_http->stop();
+	}
+	_busy = false;
+
+	uint32_t latency = micros() - _start;
+	_stats.requests++;
+	if (_reused)
+	{
+		_stats.reused++;
+	}
+	if (status == 200)
+	{
+		_remember(&_validators[0], _etag);
+		_remember(&_validators[1], _modified);
+	}
+	else if (status == 304)
+	{
+		_stats.unchanged++;
+	}
+	_stats.latency_last_us = latency;
+	_stats.latency_max_us = max(_stats.latency_max_us, latency);
+	_stats.latency_total_us += latency;
+
+	return status;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* True from session_begin() until session_poll() has returned the outcome. */
+bool session_busy(void)
+{
+	return _busy;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Drop the validators so the next request fetches the body whatever it holds, for when what is shown has moved on from
+ * the last response by some other route.
+ */
+void session_forget(void)
+{
+	_etag[0] = '\0';
+	_modified[0] = '\0';
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+const SessionStats_t * session_stats(void)
+{
+	return &_stats;
+}
+
+
+
+
+/* End of File */
@@ -0,0 +1,458 @@
+// This file was generated by tools/spangen.py from src/images.cpp, do not edit it by hand.
+
+#include <Arduino.h>
+#include "images.h"
+
+static const uint16_t Region1Index[] = {
+	0, 1, 2, 3, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 20, 23,
+	26, 28, 29, 30, 32, 33, 34, 35, 36, 37, 38, 39,
+};
+
+static const Span_t Region1Spans[] = {
+	{ 12, 2 },
+	{ 11, 7 },
+	{ 10, 11 },
+	{ 3, 1 }, { 7, 14 },
+	{ 1, 21 },
+	{ 0, 22 },
+	{ 0, 22 },
+	{ 0, 22 },
+	{ 0, 23 },
+	{ 0, 23 },
+	{ 1, 9 }, { 11, 12 },
+	{ 1, 9 }, { 11, 13 },
+	{ 1, 9 }, { 11, 13 },
+	{ 1, 8 }, { 11, 8 }, { 21, 3 },
+	{ 2, 8 }, { 11, 8 }, { 21, 2 },
+	{ 3, 7 }, { 12, 4 }, { 20, 3 },
+	{ 3, 8 }, { 20, 1 },
+	{ 3, 7 },
+	{ 4, 7 },
+	{ 4, 8 }, { 15, 1 },
+	{ 5, 7 },
+	{ 5, 7 },
+	{ 5, 6 },
+	{ 6, 4 },
+	{ 6, 3 },
+	{ 7, 1 },
+	{ 7, 1 },
+};
+
+
+static const uint16_t Region2Index[] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	17, 19, 21, 23, 25, 26, 27, 28, 29, 30, 32, 33, 34, 35, 36, 37,
+	38,
+};
+
+static const Span_t Region2Spans[] = {
+	{ 28, 1 },
+	{ 25, 4 },
+	{ 25, 3 },
+	{ 25, 2 },
+	{ 25, 3 },
+	{ 24, 4 },
+	{ 24, 5 },
+	{ 24, 6 },
+	{ 24, 6 },
+	{ 23, 8 },
+	{ 22, 15 },
+	{ 21, 16 },
+	{ 21, 16 },
+	{ 21, 17 },
+	{ 21, 14 },
+	{ 21, 14 }, { 40, 2 },
+	{ 21, 14 }, { 39, 4 },
+	{ 22, 12 }, { 38, 7 },
+	{ 22, 11 }, { 36, 9 },
+	{ 22, 11 }, { 35, 8 },
+	{ 22, 18 },
+	{ 23, 16 },
+	{ 23, 17 },
+	{ 23, 19 },
+	{ 24, 19 },
+	{ 24, 12 }, { 39, 2 },
+	{ 24, 11 },
+	{ 23, 9 },
+	{ 23, 8 },
+	{ 21, 9 },
+	{ 23, 5 },
+	{ 25, 3 },
+};
+
+
+static const uint16_t Region3Index[] = {
+	0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+	17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 28,
+};
+
+static const Span_t Region3Spans[] = {
+	{ 27, 3 }, { 31, 1 },
+	{ 27, 9 },
+	{ 27, 12 },
+	{ 27, 12 },
+	{ 27, 11 },
+	{ 27, 10 },
+	{ 28, 8 },
+	{ 28, 8 },
+	{ 28, 10 },
+	{ 28, 10 },
+	{ 28, 11 },
+	{ 28, 11 },
+	{ 27, 13 },
+	{ 26, 14 },
+	{ 25, 14 },
+	{ 25, 12 },
+	{ 24, 12 },
+	{ 22, 14 },
+	{ 21, 15 },
+	{ 20, 16 },
+	{ 23, 14 },
+	{ 24, 13 },
+	{ 25, 12 },
+	{ 26, 11 },
+	{ 26, 11 },
+	{ 31, 3 }, { 35, 1 },
+};
+
+
+static const uint16_t Region4Index[] = {
+	0, 1, 2, 5, 7, 8, 9, 10, 12, 14, 16, 18, 20, 22, 26, 29,
+	31, 32, 33, 35, 36,
+};
+
+static const Span_t Region4Spans[] = {
+	{ 33, 1 },
+	{ 31, 3 },
+	{ 21, 1 }, { 25, 1 }, { 30, 5 },
+	{ 19, 9 }, { 29, 7 },
+	{ 18, 19 },
+	{ 18, 20 },
+	{ 18, 21 },
+	{ 17, 10 }, { 29, 11 },
+	{ 17, 8 }, { 29, 11 },
+	{ 16, 9 }, { 29, 9 },
+	{ 16, 7 }, { 28, 11 },
+	{ 17, 6 }, { 27, 10 },
+	{ 17, 6 }, { 29, 8 },
+	{ 11, 3 }, { 16, 6 }, { 28, 10 }, { 40, 1 },
+	{ 12, 2 }, { 16, 5 }, { 26, 12 },
+	{ 18, 2 }, { 26, 13 },
+	{ 26, 12 },
+	{ 27, 11 },
+	{ 30, 1 }, { 32, 7 },
+	{ 36, 3 },
+};
+
+
+static const uint16_t Region5Index[] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 14, 16, 17,
+	18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32,
+};
+
+static const Span_t Region5Spans[] = {
+	{ 11, 2 },
+	{ 11, 2 },
+	{ 11, 2 },
+	{ 12, 2 },
+	{ 12, 4 },
+	{ 12, 4 },
+	{ 13, 4 },
+	{ 13, 4 },
+	{ 13, 6 },
+	{ 13, 6 },
+	{ 12, 7 },
+	{ 13, 6 },
+	{ 9, 9 }, { 22, 2 },
+	{ 10, 8 }, { 19, 7 },
+	{ 12, 15 },
+	{ 12, 14 },
+	{ 12, 13 },
+	{ 11, 14 },
+	{ 11, 14 },
+	{ 12, 13 },
+	{ 11, 13 },
+	{ 10, 14 },
+	{ 10, 14 },
+	{ 11, 13 },
+	{ 12, 11 },
+	{ 12, 10 },
+	{ 12, 9 },
+	{ 13, 8 },
+	{ 14, 7 },
+	{ 18, 3 },
+};
+
+
+static const uint16_t Region6Index[] = {
+	0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+	17, 18, 19, 20, 21, 23, 25,
+};
+
+static const Span_t Region6Spans[] = {
+	{ 28, 3 }, { 34, 1 },
+	{ 27, 9 },
+	{ 27, 9 },
+	{ 26, 11 },
+	{ 26, 11 },
+	{ 27, 9 },
+	{ 27, 9 },
+	{ 26, 10 },
+	{ 26, 10 },
+	{ 25, 12 },
+	{ 25, 12 },
+	{ 24, 14 },
+	{ 24, 14 },
+	{ 23, 15 },
+	{ 23, 15 },
+	{ 22, 16 },
+	{ 22, 16 },
+	{ 21, 16 },
+	{ 20, 16 },
+	{ 23, 12 },
+	{ 24, 1 }, { 28, 5 },
+	{ 24, 2 }, { 30, 1 },
+};
+
+
+static const uint16_t Region7Index[] = {
+	0, 1, 2, 4, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17,
+	18, 19, 20, 21, 22, 23, 24, 25,
+};
+
+static const Span_t Region7Spans[] = {
+	{ 20, 3 },
+	{ 20, 4 },
+	{ 5, 2 }, { 20, 5 },
+	{ 4, 3 }, { 19, 7 },
+	{ 18, 8 },
+	{ 17, 11 },
+	{ 18, 9 },
+	{ 18, 9 },
+	{ 19, 7 },
+	{ 19, 7 },
+	{ 18, 9 },
+	{ 17, 10 },
+	{ 17, 9 },
+	{ 18, 8 },
+	{ 18, 7 },
+	{ 17, 8 },
+	{ 18, 6 },
+	{ 18, 6 },
+	{ 18, 5 },
+	{ 17, 6 },
+	{ 17, 5 },
+	{ 18, 4 },
+	{ 19, 2 },
+};
+
+
+static const uint16_t Region8Index[] = {
+	0, 1, 3, 5, 7, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19,
+	20, 21, 22,
+};
+
+static const Span_t Region8Spans[] = {
+	{ 25, 1 },
+	{ 22, 1 }, { 24, 3 },
+	{ 15, 1 }, { 19, 8 },
+	{ 15, 2 }, { 19, 8 },
+	{ 15, 2 }, { 19, 8 },
+	{ 19, 8 },
+	{ 18, 9 },
+	{ 20, 7 },
+	{ 19, 9 },
+	{ 19, 9 },
+	{ 18, 10 },
+	{ 18, 10 },
+	{ 19, 9 },
+	{ 20, 8 },
+	{ 21, 6 },
+	{ 22, 4 },
+	{ 22, 3 },
+	{ 23, 2 },
+};
+
+
+static const uint16_t Region9Index[] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	16, 17, 18, 19,
+};
+
+static const Span_t Region9Spans[] = {
+	{ 16, 1 },
+	{ 15, 2 },
+	{ 15, 3 },
+	{ 15, 3 },
+	{ 15, 4 },
+	{ 13, 7 },
+	{ 13, 8 },
+	{ 14, 8 },
+	{ 14, 8 },
+	{ 14, 9 },
+	{ 14, 10 },
+	{ 13, 9 },
+	{ 12, 9 },
+	{ 12, 8 },
+	{ 13, 7 },
+	{ 13, 7 },
+	{ 14, 6 },
+	{ 14, 5 },
+	{ 16, 2 },
+};
+
+
+static const uint16_t Region10Index[] = {
+	0, 1, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+	17, 18,
+};
+
+static const Span_t Region10Spans[] = {
+	{ 41, 2 },
+	{ 42, 1 }, { 44, 1 },
+	{ 41, 5 },
+	{ 41, 5 },
+	{ 40, 5 },
+	{ 40, 6 },
+	{ 39, 8 },
+	{ 37, 9 },
+	{ 36, 9 },
+	{ 36, 8 },
+	{ 36, 8 },
+	{ 36, 7 },
+	{ 37, 6 },
+	{ 37, 6 },
+	{ 37, 7 },
+	{ 37, 7 },
+	{ 41, 2 },
+};
+
+
+static const uint16_t Region11Index[] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+};
+
+static const Span_t Region11Spans[] = {
+	{ 37, 4 },
+	{ 36, 7 },
+	{ 36, 8 },
+	{ 36, 8 },
+	{ 37, 7 },
+	{ 37, 7 },
+	{ 36, 7 },
+	{ 36, 6 },
+	{ 36, 6 },
+	{ 36, 7 },
+	{ 37, 5 },
+	{ 37, 5 },
+	{ 38, 7 },
+	{ 38, 5 },
+};
+
+
+static const uint16_t Region12Index[] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 12,
+};
+
+static const Span_t Region12Spans[] = {
+	{ 7, 1 },
+	{ 7, 3 },
+	{ 7, 4 },
+	{ 6, 6 },
+	{ 5, 7 },
+	{ 4, 8 },
+	{ 1, 12 },
+	{ 0, 12 },
+	{ 0, 11 },
+	{ 1, 9 },
+	{ 1, 2 }, { 4, 3 },
+};
+
+
+static const uint16_t Region13Index[] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+};
+
+static const Span_t Region13Spans[] = {
+	{ 35, 3 },
+	{ 33, 5 },
+	{ 31, 8 },
+	{ 30, 9 },
+	{ 30, 9 },
+	{ 30, 9 },
+	{ 31, 7 },
+	{ 32, 6 },
+	{ 33, 4 },
+};
+
+
+static const uint16_t Region14Index[] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+};
+
+static const Span_t Region14Spans[] = {
+	{ 28, 2 },
+	{ 27, 6 },
+	{ 28, 5 },
+	{ 28, 8 },
+	{ 29, 8 },
+	{ 30, 10 },
+	{ 30, 10 },
+	{ 31, 8 },
+	{ 37, 1 },
+};
+
+
+static const uint16_t Region15Index[] = {
+	0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 10, 10, 10, 10, 10, 10,
+	11,
+};
+
+static const Span_t Region15Spans[] = {
+	{ 36, 3 }, { 41, 2 },
+	{ 34, 9 },
+	{ 34, 9 },
+	{ 34, 8 },
+	{ 35, 7 },
+	{ 36, 6 },
+	{ 37, 4 },
+	{ 38, 3 },
+	{ 39, 2 },
+	{ 43, 1 },
+};
+
+
+static const uint16_t Region16Index[] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8,
+};
+
+static const Span_t Region16Spans[] = {
+	{ 38, 5 },
+	{ 38, 6 },
+	{ 38, 6 },
+	{ 38, 5 },
+	{ 37, 6 },
+	{ 36, 5 },
+	{ 38, 4 },
+	{ 38, 3 },
+};
+
+
+const RegionSpans_t RegionSpans[REGION_COUNT] = {
+	{ 28, 27, Region1Index, Region1Spans },
+	{ 15, 32, Region2Index, Region2Spans },
+	{ 65, 26, Region3Index, Region3Spans },
+	{ 47, 20, Region4Index, Region4Spans },
+	{ 0, 30, Region5Index, Region5Spans },
+	{ 90, 22, Region6Index, Region6Spans },
+	{ 85, 23, Region7Index, Region7Spans },
+	{ 63, 18, Region8Index, Region8Spans },
+	{ 71, 19, Region9Index, Region9Spans },
+	{ 73, 17, Region10Index, Region10Spans },
+	{ 89, 14, Region11Index, Region11Spans },
+	{ 21, 11, Region12Index, Region12Spans },
+	{ 109, 9, Region13Index, Region13Spans },
+	{ 17, 9, Region14Index, Region14Spans },
+	{ 45, 16, Region15Index, Region15Spans },
+	{ 103, 8, Region16Index, Region16Spans },
+};
@@ -0,0 +1,278 @@
+/* =====================================================================================================================
+ *      File:  /src/stream.cpp
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "pacer.pio.h"
+
+#include "constants.h"
+#include "rtt.h"
+#include "stream.h"
+
+
+
+
+//======================================================================================================================
+// Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Address lists are walked with a DMA read ring, which needs a power of two size and matching alignment.  Entries past
+// RES_HORIZ point at a blank column so a late index pulse shows black rather than repeating the image, except the first
+// which finishes the revolution when a fractional offset has cut the first column short.
+#define LIST_SIZE 128
+#define LIST_RING_BITS 9
+
+static_assert(RES_HORIZ < LIST_SIZE, "Column address list is too short for RES_HORIZ");
+static_assert(LIST_SIZE * sizeof(uint32_t) == (1 << LIST_RING_BITS), "Ring size must match the column address list");
+
+// The rgb555 program needs its start frame injected by the CPU before every column and indexed frames need resolving
+// through the palette, neither of which a DMA chain can do.
+#if (COLUMN_OUTPUT == COLUMN_OUTPUT_STREAMED) && (PIXEL_FORMAT != PIXEL_FORMAT_APA102)
+#error "Streamed column output requires PIXEL_FORMAT_APA102"
+#endif
+
+// The polled column output uses none of this and its frames need not be in wire format, so only build it if selected.
+#if COLUMN_OUTPUT == COLUMN_OUTPUT_STREAMED
+// Cycles the pacer spends on each loop in addition to the delay count.
+#define PACER_OVERHEAD 5
+
+
+
+
+//======================================================================================================================
+// Module Variables
+//----------------------------------------------------------------------------------------------------------------------
+// [buffer][left/right][column]
+static const uint32_t * _lists[2][2][LIST_SIZE] __attribute__((aligned(LIST_SIZE * sizeof(uint32_t))));
+static volatile uint8_t _active;
+static volatile uint8_t _pending;
+static volatile bool _has_pending;
+static volatile bool _enabled;
+// Fraction of a column, in 1/(1 << RTT_PHASE_SHIFT), each buffer's lists are rotated by on top of whole columns.
+static uint32_t _fractions[2];
+static const uint32_t * _blank;
+
+static PIO _pio;
+static uint8_t _pacer_sm;
+static uint8_t _pacer_offset;
+static uint8_t _tick_dma;
+static uint8_t _left_ctrl_dma;
+static uint8_t _right_ctrl_dma;
+static uint32_t _tick_sink;
+static uint32_t _cycles_per_us;
+
+
+
+
+//======================================================================================================================
+// Helpers
+//----------------------------------------------------------------------------------------------------------------------
+static void _configure_ctrl(uint8_t channel, uint8_t data_dma, uint8_t chain_to, const uint32_t ** list)
+{
+	dma_channel_config config = dma_channel_get_default_config(channel);
+	channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
+	channel_config_set_read_increment(&config, true);
+	channel_config_set_write_increment(&config, false);
+	channel_config_set_ring(&config, false, LIST_RING_BITS);
+	channel_config_set_chain_to(&config, chain_to);
+	dma_channel_configure(channel, &config, &dma_hw->ch[data_dma].al3_read_addr_trig, list, 1, false);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Point a channel's chain at another, or at itself to chain to nothing, leaving the rest of its setup alone. */
+static void _set_chain(uint8_t channel, uint8_t chain_to)
+{
+	dma_channel_config config = dma_get_channel_config(channel);
+	channel_config_set_chain_to(&config, chain_to);
+	dma_channel_set_config(channel, &config, false);
+}
+
+
+
+
+//======================================================================================================================
+// Stream Setup
+//----------------------------------------------------------------------------------------------------------------------
+/* Claim the pacer state machine and the DMA channels that feed the column buffers to the LED DMA channels.
+ *
+ * Each pacer token kicks a chain of three channels: tick drains the token, then the left and right control channels
+ * each write the next column address into the read-address trigger of their LED DMA channel before chaining back to
+ * tick to wait for the next column.
+ */
+void stream_setup(PIO pio, uint8_t left_dma, uint8_t right_dma, const Column_t * blank)
+{
+	_pio = pio;
+	_cycles_per_us = clock_get_hz(clk_sys) / 1000000;
+	_blank = *blank;
+
+	for (uint8_t buffer = 0; buffer < 2; buffer++)
+	{
+		for (uint8_t side = 0; side < 2; side++)
+		{
+			for (uint8_t column = 0; column < LIST_SIZE; column++)
+			{
+				_lists[buffer][side][column] = *blank;
+			}
+		}
+	}
+	_active = 0;
+	_fractions[0] = 0;
+	_fractions[1] = 0;
+	_has_pending = false;
+	_enabled = false;
+
+	_pacer_offset = pio_add_program(pio, &column_pacer_program);
+	_pacer_sm = pio_claim_unused_sm(pio, true);
+	column_pacer_program_init(pio, _pacer_sm, _pacer_offset);
+
+	_tick_dma = dma_claim_unused_channel(true);
+	_left_ctrl_dma = dma_claim_unused_channel(true);
+	_right_ctrl_dma = dma_claim_unused_channel(true);
+
+	dma_channel_config config = dma_channel_get_default_config(_tick_dma);
+	channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
+	channel_config_set_read_increment(&config, false);
+	channel_config_set_write_increment(&config, false);
+	channel_config_set_dreq(&config, pio_get_dreq(pio, _pacer_sm, false));
+	channel_config_set_chain_to(&config, _left_ctrl_dma);
+	dma_channel_configure(_tick_dma, &config, &_tick_sink, &pio->rxf[_pacer_sm], 1, false);
+
+	_configure_ctrl(_left_ctrl_dma, left_dma, _right_ctrl_dma, _lists[0][0]);
+	_configure_ctrl(_right_ctrl_dma, right_dma, _tick_dma, _lists[0][1]);
+}
+
+
+
+
+//======================================================================================================================
+// Stream Control
+//----------------------------------------------------------------------------------------------------------------------
+/* Rebuild the column address lists for a frame and a rotation offset in 1/(1 << RTT_PHASE_SHIFT) columns.
+ *
+ * Must be called from the same core that services the hall sensor IRQ; the new lists are picked up at the next index
+ * pulse.
+ */
+void stream_set_frame(const Frame_t * frame, uint32_t offset)
+{
+	// Prevent the IRQ from switching to the buffer about to be rebuilt.
+	_has_pending = false;
+	uint8_t buffer = !_active;
+
+	uint32_t whole = offset >> RTT_PHASE_SHIFT;
+	for (uint8_t column = 0; column <= RES_HORIZ; column++)
+	{
+		uint8_t left = (uint8_t)((column + whole) % RES_HORIZ);
+		uint8_t right = (uint8_t)((column + whole + (RES_HORIZ / 2)) % RES_HORIZ);
+		_lists[buffer][0][column] = frame->left[left];
+		_lists[buffer][1][column] = frame->right[right];
+	}
+
+	_fractions[buffer] = offset & ((1 << RTT_PHASE_SHIFT) - 1);
+	if (!_fractions[buffer])
+	{
+		_lists[buffer][0][RES_HORIZ] = _blank;
+		_lists[buffer][1][RES_HORIZ] = _blank;
+	}
+
+	_pending = buffer;
+	_has_pending = true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* True from stream_set_frame() until its lists are taken up at the next index pulse. */
+bool stream_pending(void)
+{
+	return _has_pending;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Arm the DMA chain.  Output begins at the next index pulse. */
+void stream_start(void)
+{
+	// Link the chain back up in case stream_stop() broke it.
+	_set_chain(_tick_dma, _left_ctrl_dma);
+	_set_chain(_left_ctrl_dma, _right_ctrl_dma);
+	_set_chain(_right_ctrl_dma, _tick_dma);
+	dma_channel_start(_tick_dma);
+	_enabled = true;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Stop the pacer and wait for any column in flight to finish. */
+void stream_stop(void)
+{
+	_enabled = false;
+	pio_sm_set_enabled(_pio, _pacer_sm, false);
+	pio_sm_clear_fifos(_pio, _pacer_sm);
+
+	// RP2040-E13: aborting a channel can trigger the channel it chains to, which would start the chain up again and
+	// write a stale column address into an LED channel.  Unchain them all before aborting any.
+	_set_chain(_tick_dma, _tick_dma);
+	_set_chain(_left_ctrl_dma, _left_ctrl_dma);
+	_set_chain(_right_ctrl_dma, _right_ctrl_dma);
+	dma_channel_abort(_tick_dma);
+	dma_channel_abort(_left_ctrl_dma);
+	dma_channel_abort(_right_ctrl_dma);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Restart the revolution from column zero.  Called from the hall sensor IRQ with the current revolution time. */
+void __time_critical_func(stream_index)(uint32_t period)
+{
+	if (!_enabled)
+	{
+		return;
+	}
+
+	if (_has_pending)
+	{
+		_active = _pending;
+		_has_pending = false;
+	}
+
+	pio_sm_set_enabled(_pio, _pacer_sm, false);
+	pio_sm_clear_fifos(_pio, _pacer_sm);
+	pio_sm_restart(_pio, _pacer_sm);
+
+	dma_channel_set_read_addr(_left_ctrl_dma, _lists[_active][0], false);
+	dma_channel_set_read_addr(_right_ctrl_dma, _lists[_active][1], false);
+
+	// The first column is cut short by the fractional offset, shifting the rest of the revolution by less than a
+	// column.  The pacer holds on to the second period for every column after.
+	uint32_t cycles = period * _cycles_per_us / RES_HORIZ;
+	uint32_t first = (cycles * ((1 << RTT_PHASE_SHIFT) - _fractions[_active])) >> RTT_PHASE_SHIFT;
+	pio_sm_put(_pio, _pacer_sm, first > PACER_OVERHEAD ? first - PACER_OVERHEAD : 0);
+	pio_sm_put(_pio, _pacer_sm, cycles > PACER_OVERHEAD ? cycles - PACER_OVERHEAD : 0);
+	pio_sm_exec(_pio, _pacer_sm, pio_encode_jmp(_pacer_offset));
+	pio_sm_set_enabled(_pio, _pacer_sm, true);
+}
+#endif
+
+
+
+
+/* End of File */
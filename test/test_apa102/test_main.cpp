@@ -0,0 +1,294 @@
+/* =====================================================================================================================
+ *      File:  /test/test_apa102/test_main.cpp
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <unity.h>
+
+#include "hardware/pio.h"
+#include "native.h"
+
+#include "apa102.pio.h"
+#include "frame.h"
+
+
+
+
+//======================================================================================================================
+// Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Far more than the program ever runs for one FIFO word, to stop a broken program that never stalls.
+#define STEP_LIMIT 10000
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// The parts of a state machine apa102_rgb555 uses.  The clock is on the SET pin and the data on the OUT pin.
+typedef struct
+{
+	uint8_t pc;
+	uint32_t x;
+	uint32_t y;
+	uint32_t isr;
+	uint32_t osr;
+	uint8_t osr_count;
+	bool clock;
+	bool data;
+} Machine_t;
+
+
+
+
+//======================================================================================================================
+// Module Variables
+//----------------------------------------------------------------------------------------------------------------------
+static uint32_t _put;
+
+
+
+
+//======================================================================================================================
+// Helpers
+//----------------------------------------------------------------------------------------------------------------------
+static uint32_t _source(const Machine_t * machine, uint8_t source)
+{
+	switch (source)
+	{
+	case 1: return machine->x;
+	case 2: return machine->y;
+	case 6: return machine->isr;
+	case 7: return machine->osr;
+	default: return 0;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Run the assembled apa102_rgb555 program, with both shift registers shifting right, until it stalls on an empty
+ * FIFO.  The data pin is sampled at every rising clock edge, and the bits are gathered MSB first into wire words.
+ * Only the instructions the program uses are modelled.  Returns the number of whole words sent, or 0 if it never
+ * stalls.
+ */
+static size_t _run(Machine_t * machine, const uint32_t * fifo, size_t length, uint32_t * words, size_t size)
+{
+	size_t bits = 0;
+	for (uint32_t step = 0; step < STEP_LIMIT; step++)
+	{
+		uint16_t instruction = apa102_rgb555_program_instructions[machine->pc];
+		uint8_t operand = instruction & 0x1F;
+		uint8_t field = (instruction >> 5) & 0x7;
+		uint32_t count = operand ? operand : 32;
+		uint32_t mask = (count == 32) ? ~0u : ((1u << count) - 1);
+		uint8_t next = machine->pc + 1;
+
+		switch (instruction >> 13)
+		{
+		case 0: // JMP, always or X-- only
+			if ((field == 0) || ((field == 2) && (machine->x-- != 0)))
+			{
+				next = operand;
+			}
+			break;
+
+		case 2: // IN, new bits enter at the top of the ISR
+		{
+			uint32_t data = _source(machine, field) & mask;
+			machine->isr = (count == 32) ? data : ((machine->isr >> count) | (data << (32 - count)));
+			break;
+		}
+
+		case 3: // OUT, only to null
+			machine->osr = (count == 32) ? 0 : (machine->osr >> count);
+			machine->osr_count = (machine->osr_count + count > 32) ? 32 : machine->osr_count + count;
+			break;
+
+		case 4: // PULL IFEMPTY BLOCK with a threshold of 32
+			if (machine->osr_count == 32)
+			{
+				if (length == 0)
+				{
+					return bits / 32;
+				}
+				machine->osr = *fifo++;
+				machine->osr_count = 0;
+				length--;
+			}
+			break;
+
+		case 5: // MOV to the OUT pin or the ISR, with the bit reverse
+		{
+			uint32_t data = _source(machine, instruction & 0x7);
+			if (((instruction >> 3) & 0x3) == 2)
+			{
+				uint32_t reversed = 0;
+				for (uint8_t bit = 0; bit < 32; bit++)
+				{
+					reversed |= ((data >> bit) & 1) << (31 - bit);
+				}
+				data = reversed;
+			}
+			if (field == 0)
+			{
+				machine->data = data & 1;
+			}
+			else if (field == 6)
+			{
+				machine->isr = data;
+			}
+			break;
+		}
+
+		case 7: // SET the clock pin or X
+			if (field == 0)
+			{
+				if (!machine->clock && (operand & 1) && (bits / 32 < size))
+				{
+					words[bits / 32] = (words[bits / 32] << 1) | machine->data;
+					bits++;
+				}
+				machine->clock = operand & 1;
+			}
+			else if (field == 1)
+			{
+				machine->x = operand;
+			}
+			break;
+		}
+
+		// Wrapping only takes over from running on to the next instruction, a jump taken goes where it says.
+		bool wrap = (machine->pc == apa102_rgb555_wrap) && (next == machine->pc + 1);
+		machine->pc = wrap ? apa102_rgb555_wrap_target : next;
+	}
+	// A program that never stalls sends nothing whole as far as the tests are concerned.
+	return 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+static void _capture(PIO pio, uint sm, uint32_t value)
+{
+	(void)pio;
+	(void)sm;
+	_put = value;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* A state machine waiting for pixels, with the brightness loaded into Y by apa102_rgb555_set_brightness(). */
+static Machine_t _machine(uint8_t brightness)
+{
+	native_set_pio_listener(_capture);
+	apa102_rgb555_set_brightness(pio0, 0, brightness);
+	native_set_pio_listener(NULL);
+
+	Machine_t machine = {};
+	machine.pc = apa102_rgb555_offset_pixel_out;
+	machine.y = _put;
+	machine.osr_count = 32;
+	return machine;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* The APA102 wire word for a color: 111, the brightness, then blue, green and red, each keeping its top 5 bits. */
+static uint32_t _expected(uint32_t color, uint8_t brightness)
+{
+	return 0xE0000000u | (uint32_t)brightness << 24 | (color & 0xF8) << 16 | (color & 0xF800) | (color >> 16 & 0xF8);
+}
+
+
+
+
+//======================================================================================================================
+// Tests
+//----------------------------------------------------------------------------------------------------------------------
+void setUp(void)
+{
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void tearDown(void)
+{
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+static void test_pixels_match_the_wire_format(void)
+{
+	static const uint32_t colors[] = {0xFF0000, 0x00FF00, 0x0000FF, 0xFFFFFF, 0x000000, 0x123456, 0xA5C3E7, 0x080808};
+	static const uint8_t brightnesses[] = {0, 1, 6, 16, 31};
+
+	for (uint8_t brightness : brightnesses)
+	{
+		for (uint8_t idx = 0; idx < sizeof(colors) / sizeof(colors[0]); idx += 2)
+		{
+			// The first pixel of a word is the one in its low half.
+			Machine_t machine = _machine(brightness);
+			uint32_t word = convert_rgb_to_rgb555(colors[idx]) | convert_rgb_to_rgb555(colors[idx + 1]) << 16;
+			uint32_t sent[2] = {};
+
+			TEST_ASSERT_EQUAL(2, _run(&machine, &word, 1, sent, 2));
+			TEST_ASSERT_EQUAL_HEX32(_expected(colors[idx], brightness), sent[0]);
+			TEST_ASSERT_EQUAL_HEX32(_expected(colors[idx + 1], brightness), sent[1]);
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* apa102_rgb555_start_frame() clears the ISR and jumps to bit_run, which must send it as 32 zero bits. */
+static void test_start_frame_is_zero(void)
+{
+	Machine_t machine = _machine(31);
+	machine.isr = 0;
+	machine.pc = apa102_rgb555_offset_bit_run;
+	uint32_t sent = ~0u;
+
+	TEST_ASSERT_EQUAL(1, _run(&machine, NULL, 0, &sent, 1));
+	TEST_ASSERT_EQUAL_HEX32(0, sent);
+}
+
+
+
+
+//======================================================================================================================
+// Entry Point
+//----------------------------------------------------------------------------------------------------------------------
+int main(int argc, char ** argv)
+{
+	(void)argc;
+	(void)argv;
+
+	UNITY_BEGIN();
+	RUN_TEST(test_pixels_match_the_wire_format);
+	RUN_TEST(test_start_frame_is_zero);
+	return UNITY_END();
+}
+
+
+
+
+/* End of File */
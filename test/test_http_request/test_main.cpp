@@ -0,0 +1,181 @@
+/* =====================================================================================================================
+ *      File:  /test/test_http_request/test_main.cpp
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <string.h>
+#include <string>
+#include <vector>
+#include <unity.h>
+
+#include <ArduinoHttpClient.h>
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+/* Client that keeps everything written to it, along with the size of each write(), and never has anything to read. */
+class RecordingClient : public Client
+{
+public:
+	int connect(IPAddress ip, uint16_t port) override { (void)ip; (void)port; _open = true; return 1; }
+	int connect(const char * host, uint16_t port) override { (void)host; (void)port; _open = true; return 1; }
+	size_t write(uint8_t c) override { return write(&c, 1); }
+	size_t write(const uint8_t * buffer, size_t size) override
+	{
+		sent.append((const char *)buffer, size);
+		writes.push_back(size);
+		return size;
+	}
+	int available(void) override { return 0; }
+	int read(void) override { return -1; }
+	int read(uint8_t * buffer, size_t size) override { (void)buffer; (void)size; return -1; }
+	int peek(void) override { return -1; }
+	void flush(void) override {}
+	void stop(void) override { _open = false; }
+	uint8_t connected(void) override { return _open; }
+	operator bool(void) override { return _open; }
+
+	using Print::write;
+
+	std::string sent;
+	std::vector<size_t> writes;
+
+private:
+	bool _open = false;
+};
+
+
+
+
+//======================================================================================================================
+// Tests
+//----------------------------------------------------------------------------------------------------------------------
+void setUp(void)
+{
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void tearDown(void)
+{
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+static void test_get_is_one_write(void)
+{
+	RecordingClient client;
+	HttpClient http(client, "globe.local", 8080);
+
+	TEST_ASSERT_EQUAL(HTTP_SUCCESS, http.get("/regions"));
+	TEST_ASSERT_EQUAL(1, client.writes.size());
+	TEST_ASSERT_EQUAL_STRING("GET /regions HTTP/1.1\r\nHost: globe.local:8080\r\nUser-Agent: Arduino/2.2.0\r\n"
+		"Connection: close\r\n\r\n", client.sent.c_str());
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+static void test_headers_and_basic_auth_are_one_write(void)
+{
+	RecordingClient client;
+	HttpClient http(client, "globe.local");
+	http.connectionKeepAlive();
+
+	http.beginRequest();
+	TEST_ASSERT_EQUAL(HTTP_SUCCESS, http.get("/regions"));
+	http.sendHeader("If-None-Match", "\"5d-1f\"");
+	http.sendHeader("X-Count", -42);
+	http.sendBasicAuth("globe", "pass!");
+	http.endRequest();
+
+	TEST_ASSERT_EQUAL(1, client.writes.size());
+	TEST_ASSERT_EQUAL_STRING("GET /regions HTTP/1.1\r\nHost: globe.local\r\nUser-Agent: Arduino/2.2.0\r\n"
+		"If-None-Match: \"5d-1f\"\r\nX-Count: -42\r\nAuthorization: Basic Z2xvYmU6cGFzcyE=\r\n\r\n",
+		client.sent.c_str());
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+static void test_body_that_fits_shares_the_write(void)
+{
+	RecordingClient client;
+	HttpClient http(client, "globe.local");
+	http.connectionKeepAlive();
+
+	TEST_ASSERT_EQUAL(HTTP_SUCCESS, http.post("/flags", "text/plain", 5, (const byte *)"01010"));
+	TEST_ASSERT_EQUAL(1, client.writes.size());
+	TEST_ASSERT_EQUAL_STRING("POST /flags HTTP/1.1\r\nHost: globe.local\r\nUser-Agent: Arduino/2.2.0\r\n"
+		"Content-Type: text/plain\r\nContent-Length: 5\r\n\r\n01010", client.sent.c_str());
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Requests longer than the buffer go out in pieces as it fills, none of them lost, reordered or over its size. */
+static void test_long_request_streams(void)
+{
+	RecordingClient client;
+	HttpClient http(client, "globe.local");
+	http.connectionKeepAlive();
+	std::string path = "/" + std::string(600, 'p');
+	std::string value(300, 'v');
+
+	http.beginRequest();
+	TEST_ASSERT_EQUAL(HTTP_SUCCESS, http.get(path.c_str()));
+	http.sendHeader("X-Long", value.c_str());
+	http.sendBasicAuth("globe", "pass!");
+	http.endRequest();
+
+	std::string expected = "GET " + path + " HTTP/1.1\r\nHost: globe.local\r\nUser-Agent: Arduino/2.2.0\r\nX-Long: " +
+		value + "\r\nAuthorization: Basic Z2xvYmU6cGFzcyE=\r\n\r\n";
+	TEST_ASSERT_EQUAL_STRING(expected.c_str(), client.sent.c_str());
+	TEST_ASSERT_GREATER_THAN(1, client.writes.size());
+	for (size_t size : client.writes)
+	{
+		TEST_ASSERT_LESS_OR_EQUAL(256, size);
+	}
+}
+
+
+
+
+//======================================================================================================================
+// Entry Point
+//----------------------------------------------------------------------------------------------------------------------
+int main(int argc, char ** argv)
+{
+	(void)argc;
+	(void)argv;
+
+	UNITY_BEGIN();
+	RUN_TEST(test_get_is_one_write);
+	RUN_TEST(test_headers_and_basic_auth_are_one_write);
+	RUN_TEST(test_body_that_fits_shares_the_write);
+	RUN_TEST(test_long_request_streams);
+	return UNITY_END();
+}
+
+
+
+
+/* End of File */
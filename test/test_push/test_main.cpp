@@ -0,0 +1,373 @@
+/* =====================================================================================================================
+ *      File:  /test/test_push/test_main.cpp
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <string.h>
+#include <random>
+#include <string>
+#include <vector>
+#include <unity.h>
+
+#include "native.h"
+
+#include "../../src/push.cpp"
+
+
+
+
+//======================================================================================================================
+// Definitions
+//----------------------------------------------------------------------------------------------------------------------
+#define MESSAGE_COUNT 300
+#define MESSAGE_SIZE 256
+
+// Every so often the server pings ahead of a message.
+#define PING_EVERY 5
+
+// Long enough that some messages are truncated and some need a 16-bit length.
+#define LONGEST_MESSAGE 400
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+/* Server at the other end of the socket.  The upgrade is answered at once, after that frames queued with send() are
+ * released a few bytes at a time at random whenever the client looks for data, as though trickling in off the network.
+ * Everything the client writes once upgraded is kept in sent.
+ */
+class TrickleServer : public Client
+{
+public:
+	void reset(void) { connects = 0; _open = false; _upgraded = false; _data.clear(); _position = 0; _arrived = 0; }
+
+	void send(const std::string & frame) { _data += frame; }
+
+	// Let everything sent so far arrive.
+	void land(void) { _arrived = _data.size(); }
+
+	int connect(IPAddress ip, uint16_t port) override { (void)ip; (void)port; return connect("", 0); }
+	int connect(const char * host, uint16_t port) override
+	{
+		(void)host;
+		(void)port;
+		_open = true;
+		_upgraded = false;
+		_data.clear();
+		_position = 0;
+		_arrived = 0;
+		sent.clear();
+		connects++;
+		return 1;
+	}
+	size_t write(uint8_t c) override { return write(&c, 1); }
+	size_t write(const uint8_t * buffer, size_t size) override
+	{
+		if (_upgraded)
+		{
+			sent.append((const char *)buffer, size);
+		}
+		else if ((size >= 4) && (memcmp(buffer + size - 4, "\r\n\r\n", 4) == 0))
+		{
+			// The end of the upgrade request.
+			_upgraded = true;
+			_data += "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n\r\n";
+			land();
+		}
+		return size;
+	}
+	int available(void) override { _trickle(); return _arrived - _position; }
+	int read(void) override { _trickle(); return (_position < _arrived) ? (uint8_t)_data[_position++] : -1; }
+	int read(uint8_t * buffer, size_t size) override
+	{
+		_trickle();
+		size_t count = min(size, _arrived - _position);
+		if (count == 0)
+		{
+			return -1;
+		}
+		memcpy(buffer, _data.data() + _position, count);
+		_position += count;
+		return count;
+	}
+	int peek(void) override { _trickle(); return (_position < _arrived) ? (uint8_t)_data[_position] : -1; }
+	void flush(void) override {}
+	void stop(void) override { _open = false; }
+	uint8_t connected(void) override { return _open; }
+	operator bool(void) override { return _open; }
+
+	using Print::write;
+
+	std::string sent;
+	uint32_t connects;
+
+private:
+	void _trickle(void)
+	{
+		if (_random() % 3 == 0)
+		{
+			_arrived = min(_data.size(), _arrived + _random() % 9);
+		}
+	}
+
+	std::mt19937 _random;
+	bool _open;
+	bool _upgraded;
+	std::string _data;
+	size_t _position;
+	size_t _arrived;
+};
+
+
+
+
+//======================================================================================================================
+// Module Variables
+//----------------------------------------------------------------------------------------------------------------------
+static TrickleServer _server;
+static WebSocketClient _websocket(_server, "globe.local");
+static uint8_t _message[MESSAGE_SIZE];
+
+
+
+
+//======================================================================================================================
+// Helpers
+//----------------------------------------------------------------------------------------------------------------------
+/* Frame payload as the server would send it, with the shortest length that fits unless wide is set, masked with key
+ * if one is given.
+ */
+static std::string _frame(uint8_t opcode, const std::string & payload, const uint8_t * key = NULL, bool wide = false)
+{
+	std::string frame(1, (char)(0x80 | opcode));
+	uint8_t mask = key ? 0x80 : 0x00;
+	int length_bytes = wide ? 8 : ((payload.size() < 126) ? 0 : 2);
+
+	if (length_bytes == 0)
+	{
+		frame += (char)(mask | payload.size());
+	}
+	else
+	{
+		frame += (char)(mask | ((length_bytes == 2) ? 126 : 127));
+		for (int idx = length_bytes - 1; idx >= 0; idx--)
+		{
+			frame += (char)((payload.size() >> (idx * 8)) & 0xFF);
+		}
+	}
+
+	if (!key)
+	{
+		return frame + payload;
+	}
+
+	frame.append((const char *)key, 4);
+	for (size_t idx = 0; idx < payload.size(); idx++)
+	{
+		frame += (char)(payload[idx] ^ key[idx & 3]);
+	}
+	return frame;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Unmask the payloads of the frames of opcode the client has sent. */
+static std::vector<std::string> _sent(uint8_t opcode)
+{
+	std::vector<std::string> payloads;
+	size_t idx = 0;
+	while (idx + 6 <= _server.sent.size())
+	{
+		const uint8_t * frame = (const uint8_t *)_server.sent.data() + idx;
+		size_t length = frame[1] & 0x7F;
+		std::string payload;
+		for (size_t byte = 0; byte < length; byte++)
+		{
+			payload += (char)(frame[6 + byte] ^ frame[2 + (byte & 3)]);
+		}
+		if ((frame[0] & 0x0F) == opcode)
+		{
+			payloads.push_back(payload);
+		}
+		idx += 6 + length;
+	}
+	return payloads;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Poll until a message comes through, failing after so many polls. */
+static int _poll(void)
+{
+	for (uint32_t polls = 0; polls < 100000; polls++)
+	{
+		int length = push_poll(_message, sizeof(_message));
+		if (length != 0)
+		{
+			return length;
+		}
+	}
+	return 0;
+}
+
+
+
+
+//======================================================================================================================
+// Tests
+//----------------------------------------------------------------------------------------------------------------------
+/* Time is frozen once connected so any wait inside push_poll() would show up on the clock. */
+void setUp(void)
+{
+	native_time_manual(true);
+	native_time_set_us(0);
+	_websocket.stop();
+	_server.reset();
+	push_setup(&_websocket, "/push");
+
+	push_poll(_message, sizeof(_message));
+	TEST_ASSERT_TRUE(push_connected());
+	native_time_set_us(0);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void tearDown(void)
+{
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Messages trickling in a few bytes at a time, some masked, some with pings ahead of them, all come out whole. */
+static void test_messages_arrive_in_pieces(void)
+{
+	std::mt19937 random;
+	std::vector<std::string> messages;
+	std::vector<std::string> pings;
+	for (uint32_t idx = 0; idx < MESSAGE_COUNT; idx++)
+	{
+		if (idx % PING_EVERY == 0)
+		{
+			pings.push_back(std::string("ping ") + std::to_string(idx));
+			_server.send(_frame(TYPE_PING, pings.back()));
+		}
+
+		std::string message(1 + random() % LONGEST_MESSAGE, '\0');
+		for (size_t byte = 0; byte < message.size(); byte++)
+		{
+			message[byte] = (char)random();
+		}
+		messages.push_back(message);
+
+		uint8_t key[4] = {(uint8_t)random(), (uint8_t)random(), (uint8_t)random(), (uint8_t)random()};
+		_server.send(_frame(TYPE_BINARY, message, (idx & 1) ? key : NULL, idx % 7 == 0));
+	}
+
+	for (uint32_t idx = 0; idx < MESSAGE_COUNT; idx++)
+	{
+		size_t expected = min(messages[idx].size(), sizeof(_message));
+		TEST_ASSERT_EQUAL(expected, _poll());
+		TEST_ASSERT_EQUAL_MEMORY(messages[idx].data(), _message, expected);
+	}
+
+	std::vector<std::string> pongs = _sent(TYPE_PONG);
+	TEST_ASSERT_EQUAL(pings.size(), pongs.size());
+	for (size_t idx = 0; idx < pings.size(); idx++)
+	{
+		TEST_ASSERT_EQUAL_STRING(pings[idx].c_str(), pongs[idx].c_str());
+	}
+
+	TEST_ASSERT_EQUAL(0, micros());
+	TEST_ASSERT_TRUE(push_connected());
+	TEST_ASSERT_EQUAL(1, _server.connects);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* A message that stops arriving part way through drops the connection once PUSH_CONNECT_TIMEOUT has passed, and no
+ * sooner.
+ */
+static void test_stalled_message_disconnects(void)
+{
+	std::string frame = _frame(TYPE_TEXT, std::string(100, '+'));
+	_server.send(frame.substr(0, 50));
+	_server.land();
+
+	for (uint32_t polls = 0; polls < 1000; polls++)
+	{
+		TEST_ASSERT_EQUAL(0, push_poll(_message, sizeof(_message)));
+	}
+	native_time_advance_us((PUSH_CONNECT_TIMEOUT - 1) * 1000ULL);
+	TEST_ASSERT_EQUAL(0, push_poll(_message, sizeof(_message)));
+	TEST_ASSERT_TRUE(push_connected());
+
+	native_time_advance_us(1000);
+	TEST_ASSERT_EQUAL(0, push_poll(_message, sizeof(_message)));
+	TEST_ASSERT_FALSE(push_connected());
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Likewise for a frame header cut short, which WebSocketClient gives up on itself. */
+static void test_stalled_header_disconnects(void)
+{
+	std::string frame = _frame(TYPE_TEXT, std::string(200, '-'), NULL, true);
+	_server.send(frame.substr(0, 5));
+	_server.land();
+
+	for (uint32_t polls = 0; polls < 1000; polls++)
+	{
+		TEST_ASSERT_EQUAL(0, push_poll(_message, sizeof(_message)));
+	}
+	native_time_advance_us((PUSH_CONNECT_TIMEOUT - 1) * 1000ULL);
+	TEST_ASSERT_EQUAL(0, push_poll(_message, sizeof(_message)));
+	TEST_ASSERT_TRUE(push_connected());
+
+	native_time_advance_us(1000);
+	push_poll(_message, sizeof(_message));
+	TEST_ASSERT_EQUAL(0, push_poll(_message, sizeof(_message)));
+	TEST_ASSERT_FALSE(push_connected());
+}
+
+
+
+
+//======================================================================================================================
+// Entry Point
+//----------------------------------------------------------------------------------------------------------------------
+int main(int argc, char ** argv)
+{
+	(void)argc;
+	(void)argv;
+
+	UNITY_BEGIN();
+	RUN_TEST(test_messages_arrive_in_pieces);
+	RUN_TEST(test_stalled_message_disconnects);
+	RUN_TEST(test_stalled_header_disconnects);
+	return UNITY_END();
+}
+
+
+
+
+/* End of File */
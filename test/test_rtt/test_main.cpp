@@ -0,0 +1,226 @@
+/* =====================================================================================================================
+ *      File:  /test/test_rtt/test_main.cpp
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <unity.h>
+
+#include "../../src/rtt.cpp"
+
+
+
+
+//======================================================================================================================
+// Definitions
+//----------------------------------------------------------------------------------------------------------------------
+#define PUBLISH_COUNT 2000000
+#define READER_COUNT 3
+
+
+
+
+//======================================================================================================================
+// Module Variables
+//----------------------------------------------------------------------------------------------------------------------
+static std::atomic<bool> _writing;
+static std::atomic<uint32_t> _ready;
+
+
+
+
+//======================================================================================================================
+// Helpers
+//----------------------------------------------------------------------------------------------------------------------
+/* Every field of the snapshot derived from the one count, so a copy mixing two publications can't pass for either. */
+static void _fill(Snapshot_t * snapshot, uint32_t count)
+{
+	snapshot->tracking = count & 1;
+	snapshot->last_event = count;
+	snapshot->revolution = count * 3 + 1;
+	snapshot->predicted = ~count;
+	snapshot->scale = count * 2654435761u;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+static bool _consistent(const Snapshot_t * snapshot)
+{
+	Snapshot_t expected;
+	_fill(&expected, snapshot->last_event);
+	return (snapshot->tracking == expected.tracking) && (snapshot->revolution == expected.revolution)
+		&& (snapshot->predicted == expected.predicted) && (snapshot->scale == expected.scale);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Stands in for the hall sensor IRQ, the only writer there ever is. */
+static void _writer(void)
+{
+	Snapshot_t snapshot;
+	for (uint32_t count = 1; count <= PUBLISH_COUNT; count++)
+	{
+		_fill(&snapshot, count);
+		_publish(&snapshot);
+	}
+	_writing = false;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Stands in for the output core, counting the snapshots that were torn or went back in time. */
+static void _reader(uint32_t * torn)
+{
+	uint32_t previous = 0;
+	_ready++;
+	do
+	{
+		Snapshot_t snapshot;
+		_read(&snapshot);
+		if (!_consistent(&snapshot) || (snapshot.last_event < previous))
+		{
+			(*torn)++;
+		}
+		previous = snapshot.last_event;
+	} while (_writing);
+}
+
+
+
+
+//======================================================================================================================
+// Tests
+//----------------------------------------------------------------------------------------------------------------------
+void setUp(void)
+{
+	Snapshot_t snapshot;
+	_fill(&snapshot, 0);
+	_publish(&snapshot);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void tearDown(void)
+{
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+static void test_read_returns_last_published(void)
+{
+	Snapshot_t snapshot;
+	_fill(&snapshot, 41);
+	_publish(&snapshot);
+	_fill(&snapshot, 42);
+	_publish(&snapshot);
+
+	_read(&snapshot);
+	TEST_ASSERT_EQUAL(42, snapshot.last_event);
+	TEST_ASSERT_TRUE(_consistent(&snapshot));
+	TEST_ASSERT_EQUAL(0, _sequence & 1);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* A read made while the IRQ is part way through publishing waits for it to finish rather than taking what is there. */
+static void test_read_waits_out_a_publish(void)
+{
+	Snapshot_t snapshot;
+	std::atomic<bool> done(false);
+
+	_sequence = _sequence + 1;
+	_snapshot.last_event = 1;
+	std::thread reader([&]() { _read(&snapshot); done = true; });
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	bool early = done;
+
+	Snapshot_t published;
+	_fill(&published, 1);
+	_snapshot = published;
+	_sequence = _sequence + 1;
+	reader.join();
+	TEST_ASSERT_FALSE(early);
+	TEST_ASSERT_EQUAL(1, snapshot.last_event);
+	TEST_ASSERT_TRUE(_consistent(&snapshot));
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Readers on other threads must only ever see whole snapshots, and never an older one than they saw before.  Reads
+ * only truly overlap publishing on a host with cores to spare, the case above covers that on any host.
+ */
+static void test_readers_never_see_a_torn_snapshot(void)
+{
+	uint32_t torn[READER_COUNT] = {};
+	std::vector<std::thread> readers;
+
+	_writing = true;
+	_ready = 0;
+	for (uint32_t idx = 0; idx < READER_COUNT; idx++)
+	{
+		readers.emplace_back(_reader, &torn[idx]);
+	}
+	while (_ready < READER_COUNT)
+	{
+		std::this_thread::yield();
+	}
+	std::thread writer(_writer);
+
+	writer.join();
+	for (std::thread & reader : readers)
+	{
+		reader.join();
+	}
+
+	Snapshot_t snapshot;
+	_read(&snapshot);
+	TEST_ASSERT_EQUAL(PUBLISH_COUNT, snapshot.last_event);
+	for (uint32_t idx = 0; idx < READER_COUNT; idx++)
+	{
+		TEST_ASSERT_EQUAL(0, torn[idx]);
+	}
+}
+
+
+
+
+//======================================================================================================================
+// Entry Point
+//----------------------------------------------------------------------------------------------------------------------
+int main(int argc, char ** argv)
+{
+	(void)argc;
+	(void)argv;
+
+	UNITY_BEGIN();
+	RUN_TEST(test_read_returns_last_published);
+	RUN_TEST(test_read_waits_out_a_publish);
+	RUN_TEST(test_readers_never_see_a_torn_snapshot);
+	return UNITY_END();
+}
+
+
+
+
+/* End of File */
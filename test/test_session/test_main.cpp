@@ -0,0 +1,243 @@
+/* =====================================================================================================================
+ *      File:  /test/test_session/test_main.cpp
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <string.h>
+#include <random>
+#include <string>
+#include <vector>
+#include <unity.h>
+
+#include "native.h"
+
+#include "../../src/session.cpp"
+
+
+
+
+//======================================================================================================================
+// Definitions
+//----------------------------------------------------------------------------------------------------------------------
+#define REQUEST_COUNT 500
+
+// Longer than HttpClient's response timeout.
+#define SILENCE_US 31000000ULL
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+/* Server at the other end of a client connection.  Each request written to it queues the next of its responses, which
+ * is then released a few bytes at a time at random as the client checks what is available, as though trickling in off
+ * the network.  A request with no response left to give is never answered.
+ */
+class FragmentServer : public Client
+{
+public:
+	void reset(void) { responses.clear(); connects = 0; _open = false; _data.clear(); _position = 0; _arrived = 0; }
+
+	// Let everything sent so far arrive, as it would have by the time of the next request.
+	void land(void) { _arrived = _data.size(); }
+
+	int connect(IPAddress ip, uint16_t port) override { (void)ip; (void)port; return connect("", 0); }
+	int connect(const char * host, uint16_t port) override
+	{
+		(void)host;
+		(void)port;
+		_open = true;
+		_data.clear();
+		_position = 0;
+		_arrived = 0;
+		connects++;
+		return 1;
+	}
+	size_t write(uint8_t c) override { return write(&c, 1); }
+	size_t write(const uint8_t * buffer, size_t size) override
+	{
+		if (_open && (size >= 4) && (memcmp(buffer, "GET ", 4) == 0) && !responses.empty())
+		{
+			_data += responses.front();
+			responses.erase(responses.begin());
+		}
+		return size;
+	}
+	int available(void) override
+	{
+		if (_random() % 3 == 0)
+		{
+			_arrived = min(_data.size(), _arrived + _random() % 9);
+		}
+		return _arrived - _position;
+	}
+	int read(void) override { return (_position < _arrived) ? (uint8_t)_data[_position++] : -1; }
+	int read(uint8_t * buffer, size_t size) override
+	{
+		size_t count = min(size, _arrived - _position);
+		if (count == 0)
+		{
+			return -1;
+		}
+		memcpy(buffer, _data.data() + _position, count);
+		_position += count;
+		return count;
+	}
+	int peek(void) override { return (_position < _arrived) ? (uint8_t)_data[_position] : -1; }
+	void flush(void) override {}
+	void stop(void) override { _open = false; }
+	uint8_t connected(void) override { return _open || (_position < _data.size()); }
+	operator bool(void) override { return _open; }
+
+	using Print::write;
+
+	std::vector<std::string> responses;
+	uint32_t connects;
+
+private:
+	std::mt19937 _random;
+	bool _open;
+	std::string _data;
+	size_t _position;
+	size_t _arrived;
+};
+
+
+
+
+//======================================================================================================================
+// Module Variables
+//----------------------------------------------------------------------------------------------------------------------
+static const char _sized[] = "HTTP/1.1 200 OK\r\nContent-Length: 16\r\nX-Padding: abc\r\n\r\n1010101010101010";
+static const char _chunked[] = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n8\r\n01010101\r\n8\r\n11110000\r\n"
+	"0\r\n\r\n";
+
+static FragmentServer _server;
+static HttpClient _connection(_server, "globe.local");
+static uint8_t _received[64];
+
+
+
+
+//======================================================================================================================
+// Tests
+//----------------------------------------------------------------------------------------------------------------------
+/* Time is frozen so any delay() would show up on the clock. */
+void setUp(void)
+{
+	native_time_manual(true);
+	native_time_set_us(0);
+	_connection.stop();
+	_server.reset();
+	session_setup(&_connection);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+void tearDown(void)
+{
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+static void test_fragmented_responses(void)
+{
+	for (uint32_t idx = 0; idx < REQUEST_COUNT; idx++)
+	{
+		_server.responses.push_back((idx & 1) ? _chunked : _sized);
+	}
+
+	for (uint32_t idx = 0; idx < REQUEST_COUNT; idx++)
+	{
+		_server.land();
+		TEST_ASSERT_EQUAL(HTTP_SUCCESS, session_begin("/regions", _received, sizeof(_received)));
+
+		int status;
+		int length;
+		uint32_t polls = 0;
+		while ((status = session_poll(&length)) == HTTP_PENDING)
+		{
+			TEST_ASSERT_LESS_OR_EQUAL(100000, ++polls);
+		}
+		TEST_ASSERT_EQUAL(200, status);
+		TEST_ASSERT_EQUAL(16, length);
+		TEST_ASSERT_EQUAL_MEMORY((idx & 1) ? "0101010111110000" : "1010101010101010", _received, 16);
+	}
+
+	TEST_ASSERT_EQUAL(0, micros());
+	TEST_ASSERT_EQUAL(1, _server.connects);
+	TEST_ASSERT_EQUAL(REQUEST_COUNT, session_stats()->requests);
+	TEST_ASSERT_EQUAL(REQUEST_COUNT - 1, session_stats()->reused);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* A server that never answers fails the request once the response timeout has passed, after one retry on a new
+ * connection if the first was reused, and no sooner or later.
+ */
+static void test_silent_server_times_out(void)
+{
+	_server.responses.push_back(_sized);
+	int length;
+	TEST_ASSERT_EQUAL(HTTP_SUCCESS, session_begin("/regions", _received, sizeof(_received)));
+	while (session_poll(&length) == HTTP_PENDING)
+	{
+	}
+	_server.land();
+
+	TEST_ASSERT_EQUAL(HTTP_SUCCESS, session_begin("/regions", _received, sizeof(_received)));
+	TEST_ASSERT_EQUAL(HTTP_PENDING, session_poll(&length));
+	TEST_ASSERT_EQUAL(0, micros());
+
+	native_time_advance_us(SILENCE_US);
+	TEST_ASSERT_EQUAL(HTTP_PENDING, session_poll(&length));
+	TEST_ASSERT_EQUAL(1, session_stats()->retries);
+	TEST_ASSERT_EQUAL(2, _server.connects);
+
+	native_time_advance_us(SILENCE_US);
+	TEST_ASSERT_EQUAL(HTTP_ERROR_TIMED_OUT, session_poll(&length));
+	TEST_ASSERT_FALSE(session_busy());
+	TEST_ASSERT_EQUAL(1, session_stats()->failures);
+	TEST_ASSERT_EQUAL(2 * SILENCE_US, micros());
+}
+
+
+
+
+//======================================================================================================================
+// Entry Point
+//----------------------------------------------------------------------------------------------------------------------
+int main(int argc, char ** argv)
+{
+	(void)argc;
+	(void)argv;
+
+	UNITY_BEGIN();
+	RUN_TEST(test_fragmented_responses);
+	RUN_TEST(test_silent_server_times_out);
+	return UNITY_END();
+}
+
+
+
+
+/* End of File */
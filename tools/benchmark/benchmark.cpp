@@ -0,0 +1,319 @@
+/* =====================================================================================================================
+ *      File:  /tools/benchmark/benchmark.cpp
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "hardware/flash.h"
+#include "native.h"
+
+#include "constants.h"
+#include "frame.h"
+#include "images.h"
+#include "library.h"
+#include "renderer.h"
+
+
+
+
+//======================================================================================================================
+// Definitions
+//----------------------------------------------------------------------------------------------------------------------
+#if IMAGE_FORMAT == IMAGE_FORMAT_LABELS
+#define IMAGE_FORMAT_NAME "labels"
+#else
+#define IMAGE_FORMAT_NAME "spans"
+#endif
+
+#if PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+#define PIXEL_FORMAT_NAME "indexed"
+#elif PIXEL_FORMAT == PIXEL_FORMAT_RGB555
+#define PIXEL_FORMAT_NAME "rgb555"
+#else
+#define PIXEL_FORMAT_NAME "apa102"
+#endif
+
+
+
+
+//======================================================================================================================
+// Module Variables
+//----------------------------------------------------------------------------------------------------------------------
+static Frame_t _reference;
+static bool _active[REGION_COUNT];
+
+static const LibraryImage_t * _image;
+static uint16_t _frame;
+static uint8_t _labels[RES_VERT];
+static uint32_t _label_sum;
+#if PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+static Column_t _resolved[2];
+#endif
+
+
+
+
+//======================================================================================================================
+// Helpers
+//----------------------------------------------------------------------------------------------------------------------
+/* The original renderer: clear the frame and test every bit of every region bitmap. */
+static void _render_bitmaps(void)
+{
+	frame_clear(&_reference);
+
+	for (uint8_t idx = 0; idx < REGION_COUNT; idx++)
+	{
+		const Region_t * region = Regions[idx];
+#if PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+		// Indexed frames hold each region's palette index instead of its color.
+		uint32_t pixel = idx + 1;
+#else
+		uint32_t pixel = frame_convert(_active[idx] ? ColorMap[idx] : INACTIVE_COLOR);
+#endif
+
+		for (uint8_t column = 0; column < REGION_WIDTH; column++)
+		{
+			for (uint8_t row = 0; row < REGION_HEIGHT; row++)
+			{
+				if ((*region)[column][row / 8] & (1 << (7 - (row % 8))))
+				{
+					frame_merge(&_reference, column + REGION_OFFSET_X, row + REGION_OFFSET_Y, pixel);
+				}
+			}
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+static void _render_full(void)
+{
+	renderer_invalidate(0, RES_HORIZ);
+	renderer_commit();
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+static void _render_toggle(void)
+{
+	static uint8_t region = 0;
+
+	region = (region + 1) % REGION_COUNT;
+	_active[region] = !_active[region];
+	renderer_set_region(region, _active[region]);
+	renderer_commit();
+}
+
+
+#if PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+//----------------------------------------------------------------------------------------------------------------------
+/* The work indexed frames add to the output core, resolving both halves of a column through the palette. */
+static void _resolve_column(void)
+{
+	static uint8_t column = 0;
+
+	column = (column + 1) % RES_HORIZ;
+	const Frame_t * frame = renderer_acquire();
+	renderer_release();
+	frame_resolve_column(&frame->left[column], renderer_palette(), &_resolved[0]);
+	frame_resolve_column(&frame->right[column], renderer_palette(), &_resolved[1]);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Sum the resolved columns, printed so the compiler can't discard the lookups as unused. */
+static uint32_t _resolved_checksum(void)
+{
+	uint32_t sum = 0;
+	for (uint8_t idx = 0; idx < COLUMN_WORDS; idx++)
+	{
+		sum += _resolved[0][idx] ^ _resolved[1][idx];
+	}
+	return sum;
+}
+#endif
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Check the frame last published by the renderer against the bitmap scan of the same regions, so a renderer that is
+ * fast but wrong doesn't pass.
+ */
+static bool _matches_reference(const char * name)
+{
+	_render_bitmaps();
+	const Frame_t * frame = renderer_acquire();
+	bool matches = (memcmp(frame, &_reference, sizeof(Frame_t)) == 0);
+	renderer_release();
+
+	if (!matches)
+	{
+		fprintf(stderr, "%s differs from the bitmap scan\n", name);
+	}
+	return matches;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Decode the next frame of the library image straight into the back buffer, as switching content does. */
+static void _decode_draw(void)
+{
+	_frame++;
+	renderer_set_image(_image, _frame);
+	renderer_invalidate(0, RES_HORIZ);
+	renderer_commit();
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Expand every run of the next frame into a column of labels, the decode without any drawing. */
+static void _decode_only(void)
+{
+	_frame++;
+	const uint8_t * frame = library_frame(_image, _frame);
+
+	for (uint8_t column = 0; column < RES_HORIZ; column++)
+	{
+		const uint8_t * end;
+		const uint8_t * run = library_column(frame, column, &end);
+		for (uint8_t row = 0; (run < end) && (run[0] <= RES_VERT - row); run += 2)
+		{
+			memset(&_labels[row], run[1], run[0]);
+			row += run[0];
+		}
+		_label_sum += _labels[column % RES_VERT];
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Run a render repeatedly and report the mean time of one call. */
+static double _measure(const char * name, void (*render)(void), uint32_t iterations)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t idx = 0; idx < iterations; idx++)
+	{
+		render();
+	}
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	double us = std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+	printf("%-28s %10.2f us\n", name, us);
+	return us;
+}
+
+
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Time decoding every image of a library file, loaded where the firmware expects to find it in flash. */
+static bool _benchmark_library(const char * path, uint32_t iterations)
+{
+	if (!native_flash_load(LIBRARY_FLASH_OFFSET, path)
+		|| !library_setup((const uint8_t *)(XIP_BASE + LIBRARY_FLASH_OFFSET), LIBRARY_FLASH_SIZE))
+	{
+		fprintf(stderr, "%s is not a valid image library\n", path);
+		return false;
+	}
+
+	for (uint16_t idx = 0; idx < library_count(); idx++)
+	{
+		_image = library_image(idx);
+
+		// The last column offset of a frame is its packed size.
+		uint32_t bytes = 0;
+		for (uint16_t frame = 0; frame < _image->frame_count; frame++)
+		{
+			bytes += ((const uint16_t *)library_frame(_image, frame))[RES_HORIZ];
+		}
+		bytes /= _image->frame_count;
+
+		printf("library image %.*s, %u frames, %u bytes a frame packed\n", LIBRARY_NAME_SIZE, _image->name,
+			_image->frame_count, bytes);
+		double draw = _measure("library, decode and draw", _decode_draw, iterations);
+		double decode = _measure("library, decode only", _decode_only, iterations);
+		printf("decode %.1f MB/s, %.1f Mpixel/s drawn\n", bytes / decode, RES_HORIZ * RES_VERT / draw);
+	}
+
+	renderer_set_image(NULL, 0);
+	renderer_commit();
+	printf("decoded label checksum %08x\n", _label_sum);
+	return true;
+}
+
+
+
+
+//======================================================================================================================
+// Entry Point
+//----------------------------------------------------------------------------------------------------------------------
+/* Time the region renderer against the original bitmap scan on the host, then the decoding of a flash image library
+ * packed by tools/imagepack.py if one is given: `program [iterations] [library.bin]`.
+ *
+ * Absolute numbers only describe the host, but the ratios carry over to the RP2040 well enough to compare image
+ * formats.  Build once per IMAGE_FORMAT and PIXEL_FORMAT to compare them with each other.
+ */
+int main(int argc, char ** argv)
+{
+	uint32_t iterations = (argc > 1) ? strtoul(argv[1], NULL, 0) : 2000;
+	const char * library = (argc > 2) ? argv[2] : NULL;
+
+	renderer_setup();
+	for (uint8_t idx = 0; idx < REGION_COUNT; idx++)
+	{
+		_active[idx] = idx & 1;
+		renderer_set_region(idx, _active[idx]);
+	}
+	renderer_commit();
+
+	printf("image format %s, pixel format %s, %u iterations\n", IMAGE_FORMAT_NAME, PIXEL_FORMAT_NAME, iterations);
+	double bitmaps = _measure("bitmap scan, full frame", _render_bitmaps, iterations);
+	double full = _measure("renderer, full frame", _render_full, iterations);
+	if (!_matches_reference("renderer, full frame"))
+	{
+		return 1;
+	}
+	double toggle = _measure("renderer, one region toggled", _render_toggle, iterations);
+	if (!_matches_reference("renderer, one region toggled"))
+	{
+		return 1;
+	}
+	printf("full frame %.1fx faster, region toggle %.1fx faster than the bitmap scan\n", bitmaps / full,
+		bitmaps / toggle);
+#if PIXEL_FORMAT == PIXEL_FORMAT_INDEXED
+	_measure("palette resolve, per column", _resolve_column, iterations);
+	printf("resolved column checksum %08x\n", _resolved_checksum());
+#endif
+
+	if (library && !_benchmark_library(library, iterations))
+	{
+		return 1;
+	}
+	return 0;
+}
+
+
+
+
+/* End of File */
@@ -0,0 +1,185 @@
+/* =====================================================================================================================
+ *      File:  /tools/columnbench/columnbench.cpp
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include "constants.h"
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// One half of the strip as it goes out on the wire: start frame, LED_COUNT APA102 pixels (far end first), end frame.
+typedef uint32_t Column_t[COLUMN_BUFFER_SIZE];
+
+
+
+
+//======================================================================================================================
+// Module Variables
+//----------------------------------------------------------------------------------------------------------------------
+// The frame as render() used to leave it, RGB in rows.
+static uint32_t _rgb[RES_HORIZ][RES_VERT];
+
+// The same frame as render() leaves it now, in wire format and split into the halves of each column.
+static Column_t _left[RES_HORIZ];
+static Column_t _right[RES_HORIZ];
+
+// The alternating pair of column buffers loop1() used to convert into.
+static Column_t _converted[2][2];
+static uint8_t _buffer;
+
+// Where the DMA channels would be pointed, volatile so neither way of getting there can be optimized out.
+static const uint32_t * volatile _column_left;
+static const uint32_t * volatile _column_right;
+
+
+
+
+//======================================================================================================================
+// Helpers
+//----------------------------------------------------------------------------------------------------------------------
+/* Convert an RGB color into an APA102 pixel word at the global brightness, as loop1() did for every LED. */
+static inline uint32_t _convert(uint32_t value)
+{
+	uint8_t red = (value >> 16) & 0xFF;
+	uint8_t green = (value >> 8) & 0xFF;
+	uint8_t blue = value & 0xFF;
+
+	return 0x7 << 29 | (BRIGHTNESS & 0x1f) << 24 | (uint32_t)blue << 16 | (uint32_t)green << 8 | (uint32_t)red;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* The old output core: convert both halves of every column of a revolution from the RGB frame, pixel by pixel. */
+static void _columns_convert(void)
+{
+	for (uint8_t column = 0; column < RES_HORIZ; column++)
+	{
+		uint8_t opposite = (uint8_t)(((uint16_t)column + (RES_HORIZ / 2)) % RES_HORIZ);
+		_buffer ^= 1;
+		for (uint8_t idx = 0; idx < LED_COUNT; idx++)
+		{
+			_converted[_buffer][0][LED_COUNT - idx] = _convert(_rgb[column][idx * 2 + 1]);
+			_converted[_buffer][1][LED_COUNT - idx] = _convert(_rgb[opposite][idx * 2]);
+		}
+		_column_left = _converted[_buffer][0];
+		_column_right = _converted[_buffer][1];
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* The new output core: point at both halves of every column of a revolution, already in wire format. */
+static void _columns_swap(void)
+{
+	for (uint8_t column = 0; column < RES_HORIZ; column++)
+	{
+		uint8_t opposite = (uint8_t)(((uint16_t)column + (RES_HORIZ / 2)) % RES_HORIZ);
+		_column_left = _left[column];
+		_column_right = _right[opposite];
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Run one way of producing a revolution of columns repeatedly and report the mean time of one column. */
+static double _measure(const char * name, void (*columns)(void), uint32_t iterations)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t idx = 0; idx < iterations; idx++)
+	{
+		columns();
+	}
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	double ns = std::chrono::duration<double, std::nano>(elapsed).count() / iterations / RES_HORIZ;
+	printf("%-28s %10.2f ns\n", name, ns);
+	return ns;
+}
+
+
+
+
+//======================================================================================================================
+// Entry Point
+//----------------------------------------------------------------------------------------------------------------------
+/* Time the per-column work of the output core, converting RGB pixels as it used to against pointing at columns stored
+ * in wire format, then check both give the same words: `program [iterations]`.
+ *
+ * Needs nothing but the project constants, so it builds with any host compiler:
+ * `g++ -O2 -Iinclude tools/columnbench/columnbench.cpp -o columnbench`.  Absolute numbers only describe the host.
+ */
+int main(int argc, char ** argv)
+{
+	uint32_t iterations = (argc > 1) ? strtoul(argv[1], NULL, 0) : 2000;
+
+	srand(1);
+	for (uint8_t column = 0; column < RES_HORIZ; column++)
+	{
+		for (uint8_t row = 0; row < RES_VERT; row++)
+		{
+			_rgb[column][row] = rand() & 0xFFFFFF;
+		}
+	}
+	for (uint8_t column = 0; column < RES_HORIZ; column++)
+	{
+		_left[column][0] = 0;
+		_right[column][0] = 0;
+		for (uint8_t idx = 0; idx < LED_COUNT; idx++)
+		{
+			_left[column][LED_COUNT - idx] = _convert(_rgb[column][idx * 2 + 1]);
+			_right[column][LED_COUNT - idx] = _convert(_rgb[column][idx * 2]);
+		}
+		_left[column][COLUMN_BUFFER_SIZE - 1] = ~0;
+		_right[column][COLUMN_BUFFER_SIZE - 1] = ~0;
+	}
+
+	printf("%u columns of %u LEDs, %u iterations\n", RES_HORIZ, LED_COUNT, iterations);
+	double convert = _measure("convert, per column", _columns_convert, iterations);
+	double swap = _measure("pointer swap, per column", _columns_swap, iterations);
+	printf("pointer swap %.0fx faster\n", convert / swap);
+
+	// The last column converted must match the stored one word for word.
+	const uint32_t * left = _left[RES_HORIZ - 1];
+	const uint32_t * right = _right[RES_HORIZ / 2 - 1];
+	for (uint8_t idx = 1; idx <= LED_COUNT; idx++)
+	{
+		if ((_converted[_buffer][0][idx] != left[idx]) || (_converted[_buffer][1][idx] != right[idx]))
+		{
+			fprintf(stderr, "converted and stored columns differ at LED %u\n", idx);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+
+
+/* End of File */
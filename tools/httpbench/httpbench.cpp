@@ -0,0 +1,296 @@
+/* =====================================================================================================================
+ *      File:  /tools/httpbench/httpbench.cpp
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "native.h"
+
+#include <ArduinoHttpClient.h>
+
+
+
+
+//======================================================================================================================
+// Definitions
+//----------------------------------------------------------------------------------------------------------------------
+// Most a read can return, the payload of one full size TCP segment as the WiFi stack hands them over.
+#define SEGMENT_SIZE 1460
+#define RECORDING_SIZE (20 * 1024)
+#define BODY_SIZE (16 * 1024)
+
+// Headers a typical server sends along with every response.
+#define COMMON_HEADERS \
+	"Date: Tue, 01 Jan 2030 00:00:00 GMT\r\n" \
+	"Server: nginx/1.24.0\r\n" \
+	"Content-Type: text/plain\r\n" \
+	"ETag: \"5f2b-1a2b3c4d\"\r\n" \
+	"Cache-Control: no-cache\r\n" \
+	"Connection: keep-alive\r\n"
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+typedef struct
+{
+	const char * name;
+	int status;
+	size_t body;
+	bool chunked;
+} Recording_t;
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Client playing back a recorded response SEGMENT_SIZE bytes at a time, as though straight off the network.  Anything
+ * written to it goes nowhere.
+ */
+class ReplayClient : public Client
+{
+public:
+	void load(const char * data, size_t length) { _data = data; _length = length; _position = 0; }
+
+	int connect(IPAddress ip, uint16_t port) override { (void)ip; (void)port; return 1; }
+	int connect(const char * host, uint16_t port) override { (void)host; (void)port; return 1; }
+	size_t write(uint8_t c) override { (void)c; return 1; }
+	size_t write(const uint8_t * buffer, size_t size) override { (void)buffer; return size; }
+	int available(void) override { return (_length - _position < SEGMENT_SIZE) ? _length - _position : SEGMENT_SIZE; }
+	int read(void) override { return (_position < _length) ? (uint8_t)_data[_position++] : -1; }
+	int read(uint8_t * buffer, size_t size) override
+	{
+		size_t count = min(size, (size_t)available());
+		if (count == 0)
+		{
+			return -1;
+		}
+		memcpy(buffer, _data + _position, count);
+		_position += count;
+		return count;
+	}
+	int peek(void) override { return (_position < _length) ? (uint8_t)_data[_position] : -1; }
+	void flush(void) override {}
+	void stop(void) override {}
+	uint8_t connected(void) override { return _position < _length; }
+	operator bool(void) override { return true; }
+
+	using Print::write;
+
+private:
+	const char * _data;
+	size_t _length;
+	size_t _position;
+};
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* HttpClient made ready to read a response without sending a request first, so only the parsing is timed. */
+class ReplayHttpClient : public HttpClient
+{
+public:
+	ReplayHttpClient(Client & client) : HttpClient(client, "globe.local") {}
+
+	void expect(void) { stop(); startResponse(); }
+};
+
+
+
+
+//======================================================================================================================
+// Module Variables
+//----------------------------------------------------------------------------------------------------------------------
+static const Recording_t _recordings[] = {
+	{"regions, 16 B", 200, 16, false},
+	{"not modified", 304, 0, false},
+	{"chunked, 1 KiB", 200, 1024, true},
+	{"image, 16 KiB", 200, BODY_SIZE, false},
+};
+
+static char _recording[RECORDING_SIZE];
+static size_t _recording_length;
+
+static ReplayClient _replay;
+static ReplayHttpClient _http(_replay);
+
+static uint8_t _body[BODY_SIZE];
+static uint8_t _packet[SEGMENT_SIZE];
+static uint32_t _hash;
+static int _status;
+
+
+
+
+//======================================================================================================================
+// Helpers
+//----------------------------------------------------------------------------------------------------------------------
+/* Fold data into an FNV-1a hash, to check both parsers found the same body. */
+static uint32_t _fold(uint32_t hash, const uint8_t * data, size_t length)
+{
+	for (size_t idx = 0; idx < length; idx++)
+	{
+		hash = (hash ^ data[idx]) * 16777619u;
+	}
+	return hash;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Write out a response as a server would send it, with a body of region flags. */
+static void _record(const Recording_t * recording)
+{
+	int length = snprintf(_recording, sizeof(_recording), "HTTP/1.1 %d %s\r\n" COMMON_HEADERS, recording->status,
+		(recording->status == 200) ? "OK" : "Not Modified");
+
+	if (recording->chunked)
+	{
+		length += snprintf(_recording + length, sizeof(_recording) - length, "Transfer-Encoding: chunked\r\n\r\n");
+	}
+	else
+	{
+		length += snprintf(_recording + length, sizeof(_recording) - length, "Content-Length: %u\r\n\r\n",
+			(unsigned)recording->body);
+	}
+
+	// Chunks of 256 bytes, each behind its size line and followed by CRLF.
+	for (size_t idx = 0; idx < recording->body; idx++)
+	{
+		if (recording->chunked && ((idx % 256) == 0))
+		{
+			size_t chunk = min((size_t)256, recording->body - idx);
+			length += snprintf(_recording + length, sizeof(_recording) - length, "%s%x\r\n", idx ? "\r\n" : "",
+				(unsigned)chunk);
+		}
+		_recording[length++] = '0' + ((idx * 7) % 3 == 0);
+	}
+	if (recording->chunked)
+	{
+		length += snprintf(_recording + length, sizeof(_recording) - length, "%s0\r\n\r\n",
+			recording->body ? "\r\n" : "");
+	}
+
+	_recording_length = length;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* The existing path: HttpClient reading the response into a body buffer, as the session does. */
+static void _parse_client(void)
+{
+	_replay.load(_recording, _recording_length);
+	_http.expect();
+
+	int length;
+	while ((_status = _http.pollResponse(_body, sizeof(_body), &length)) == HTTP_PENDING)
+	{
+	}
+	_hash = _fold(2166136261u, _body, length);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+static int _on_body(void * context, const uint8_t * data, size_t length)
+{
+	(void)context;
+	_hash = _fold(_hash, data, length);
+	return 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+static const HttpResponseCallbacks _callbacks = {NULL, NULL, NULL, _on_body, NULL};
+static HttpResponseParser _parser(_callbacks);
+
+/* The parser, taking the body in place from each packet read. */
+static void _parse_parser(void)
+{
+	_replay.load(_recording, _recording_length);
+	_parser.reset();
+	_hash = 2166136261u;
+
+	while (_parser.poll(_replay, _packet, sizeof(_packet)) == HTTP_PENDING)
+	{
+	}
+	_status = _parser.complete() ? _parser.statusCode() : HTTP_ERROR_INVALID_RESPONSE;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Parse the recording repeatedly and report the mean time of one response. */
+static double _measure(const char * name, void (*parse)(void), uint32_t iterations)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t idx = 0; idx < iterations; idx++)
+	{
+		parse();
+	}
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	double us = std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+	printf("  %-26s %10.3f us %8.1f MB/s\n", name, us, _recording_length / us);
+	return us;
+}
+
+
+
+
+//======================================================================================================================
+// Entry Point
+//----------------------------------------------------------------------------------------------------------------------
+/* Time HttpResponseParser against HttpClient parsing the same recorded responses on the host: `program [iterations]`.
+ *
+ * Both read the recording as it would come off the network, a segment at a time.  Absolute numbers only describe the
+ * host, but the ratio between the two carries over to the RP2040 well enough.
+ */
+int main(int argc, char ** argv)
+{
+	uint32_t iterations = (argc > 1) ? strtoul(argv[1], NULL, 0) : 20000;
+
+	printf("%u iterations, %u byte segments\n", iterations, SEGMENT_SIZE);
+	for (const Recording_t & recording : _recordings)
+	{
+		_record(&recording);
+		printf("%s, %u bytes\n", recording.name, (unsigned)_recording_length);
+
+		double client = _measure("HttpClient", _parse_client, iterations);
+		int client_status = _status;
+		uint32_t client_hash = _hash;
+
+		double parser = _measure("HttpResponseParser", _parse_parser, iterations);
+		if ((_status != client_status) || (_hash != client_hash) || (_status != recording.status))
+		{
+			fprintf(stderr, "responses differ: status %d and %d, body %08x and %08x\n", client_status, _status,
+				client_hash, _hash);
+			return 1;
+		}
+		printf("  %.1fx faster\n", client / parser);
+	}
+	return 0;
+}
+
+
+
+
+/* End of File */
@@ -0,0 +1,258 @@
+#!/usr/bin/env python3
+# =====================================================================================================================
+#      File:  /tools/imagepack.py
+#   Project:  POV Globe
+# ---------------------------------------------------------------------------------------------------------------------
+"""Pack PNG images and animations into the flash image library read by src/library.cpp.
+
+Every image is RES_HORIZ by RES_VERT pixels, one column per column of the globe and the top row at the top.  Black or
+transparent pixels are background, every other color gets a label of its own.  Labels 1 to 16 follow the region flags
+like the built-in regions, so list the region colors first with --palette for an image that should be driven by the
+server.  The frames of an animation share one set of labels.  Each column is stored as runs of (length, label) bytes,
+which decode with a single sequential pass over flash.  Run from the repository root:
+
+    python tools/imagepack.py library.bin --regions src/images.cpp --image world world.png --image spin:100 a.png b.png
+    picotool load -t bin -o 0x10100000 library.bin
+"""
+import argparse
+import itertools
+import re
+import struct
+import zlib
+
+from spangen import REGION_HEIGHT, parse_regions
+
+
+RES_HORIZ = 120
+RES_VERT = 104
+REGION_OFFSET_X = 1
+REGION_OFFSET_Y = 24
+
+PALETTE_SIZE = 64
+LIBRARY_MAGIC = 0x4C475650
+LIBRARY_VERSION = 1
+LIBRARY_NAME_SIZE = 16
+LIBRARY_FLASH_SIZE = 512 * 1024
+
+HEADER = struct.Struct('<IHHI')
+IMAGE = struct.Struct(f'<{LIBRARY_NAME_SIZE}sHHB3xII')
+COLUMNS = struct.Struct(f'<{RES_HORIZ + 1}H')
+
+COLOR_PATTERN = re.compile(r'ColorMap\[\w*\] = \{(.*?)\};', re.S)
+
+
+
+
+def read_png(path):
+    """Decode a non-interlaced PNG into rows of (red, green, blue, alpha) tuples."""
+    with open(path, 'rb') as file:
+        data = file.read()
+    if data[:8] != b'\x89PNG\r\n\x1a\n':
+        raise SystemExit(f'{path} is not a PNG')
+
+    chunks = {}
+    position = 8
+    while position < len(data):
+        length, kind = struct.unpack('>I4s', data[position:position + 8])
+        chunks.setdefault(kind, []).append(data[position + 8:position + 8 + length])
+        position += length + 12
+
+    width, height, depth, color_type, _, _, interlace = struct.unpack('>IIBBBBB', chunks[b'IHDR'][0])
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[color_type]
+    if interlace or (depth != 8 and color_type != 3):
+        raise SystemExit(f'{path}: only 8-bit non-interlaced images, or palette images, are supported')
+
+    palette = []
+    if color_type == 3:
+        plte = chunks[b'PLTE'][0]
+        alpha = chunks.get(b'tRNS', [b''])[0]
+        palette = [tuple(plte[idx * 3:idx * 3 + 3]) + (alpha[idx] if idx < len(alpha) else 255,)
+                   for idx in range(len(plte) // 3)]
+
+    raw = zlib.decompress(b''.join(chunks[b'IDAT']))
+    stride = (width * channels * depth + 7) // 8
+    pixel_bytes = max(1, channels * depth // 8)
+    rows = []
+    previous = bytearray(stride)
+    position = 0
+
+    for _ in range(height):
+        kind = raw[position]
+        line = bytearray(raw[position + 1:position + 1 + stride])
+        position += stride + 1
+        for idx in range(stride):
+            left = line[idx - pixel_bytes] if idx >= pixel_bytes else 0
+            up = previous[idx]
+            corner = previous[idx - pixel_bytes] if idx >= pixel_bytes else 0
+            if kind == 1:
+                line[idx] = (line[idx] + left) & 0xFF
+            elif kind == 2:
+                line[idx] = (line[idx] + up) & 0xFF
+            elif kind == 3:
+                line[idx] = (line[idx] + (left + up) // 2) & 0xFF
+            elif kind == 4:
+                estimate = left + up - corner
+                nearest = min((abs(estimate - left), 0, left), (abs(estimate - up), 1, up),
+                              (abs(estimate - corner), 2, corner))[2]
+                line[idx] = (line[idx] + nearest) & 0xFF
+        previous = line
+
+        if color_type == 3:
+            per_byte = 8 // depth
+            indices = [(line[idx // per_byte] >> (8 - depth * (idx % per_byte + 1))) & ((1 << depth) - 1)
+                       for idx in range(width)]
+            rows.append([palette[index] for index in indices])
+        elif color_type == 0:
+            rows.append([(value, value, value, 255) for value in line])
+        elif color_type == 4:
+            rows.append([(line[idx], line[idx], line[idx], line[idx + 1]) for idx in range(0, len(line), 2)])
+        elif color_type == 2:
+            rows.append([tuple(line[idx:idx + 3]) + (255,) for idx in range(0, len(line), 3)])
+        else:
+            rows.append([tuple(line[idx:idx + 4]) for idx in range(0, len(line), 4)])
+
+    return width, height, rows
+
+
+
+
+def label_png(path, colors):
+    """Return a PNG as columns of labels, adding any color not yet in colors to the end of it."""
+    width, height, rows = read_png(path)
+    if (width, height) != (RES_HORIZ, RES_VERT):
+        raise SystemExit(f'{path} is {width}x{height}, images must be {RES_HORIZ}x{RES_VERT}')
+
+    columns = [[0] * RES_VERT for _ in range(RES_HORIZ)]
+    for column in range(RES_HORIZ):
+        for row in range(RES_VERT):
+            red, green, blue, alpha = rows[row][column]
+            color = red << 16 | green << 8 | blue
+            if alpha == 0 or color == 0:
+                continue
+            if color not in colors:
+                colors.append(color)
+            columns[column][row] = colors.index(color) + 1
+    return columns
+
+
+
+
+def label_regions(images):
+    """Return the built-in regions of images.cpp as a labelled frame and the region colors."""
+    with open(images, newline='') as file:
+        source = file.read().replace('\r\n', '\n')
+
+    colors = [int(value, 0) for value in COLOR_PATTERN.search(source).group(1).split(',') if value.strip()]
+    columns = [[0] * RES_VERT for _ in range(RES_HORIZ)]
+    for number, (_, bitmap) in enumerate(parse_regions(source), start=1):
+        for column, values in enumerate(bitmap):
+            for row in range(REGION_HEIGHT):
+                if values[row // 8] & (0x80 >> (row % 8)):
+                    columns[column + REGION_OFFSET_X][row + REGION_OFFSET_Y] = number
+    return columns, colors
+
+
+
+
+def encode_frame(columns):
+    """Run length encode a frame behind its table of column offsets."""
+    offsets = []
+    runs = bytearray()
+    for column in columns:
+        offsets.append(COLUMNS.size + len(runs))
+        for label, group in itertools.groupby(column):
+            length = len(list(group))
+            while length:
+                chunk = min(length, 255)
+                runs += bytes((chunk, label))
+                length -= chunk
+    offsets.append(COLUMNS.size + len(runs))
+
+    if offsets[-1] > 0xFFFF:
+        raise SystemExit('frame is too complex for 16-bit column offsets')
+    return COLUMNS.pack(*offsets) + runs
+
+
+
+
+def align(data, alignment=4):
+    data += bytes(-len(data) % alignment)
+
+
+
+
+def pack(images):
+    """Lay out the library: header, image table, then the colors, frame table and frames of each image."""
+    data = bytearray(HEADER.size + IMAGE.size * len(images))
+    entries = []
+
+    for name, frame_time, colors, frames in images:
+        colors_offset = len(data)
+        data += struct.pack(f'<{len(colors)}I', *colors)
+
+        frames_offset = len(data)
+        data += bytes(4 * len(frames))
+        for idx, frame in enumerate(frames):
+            align(data)
+            struct.pack_into('<I', data, frames_offset + 4 * idx, len(data))
+            data += encode_frame(frame)
+        align(data)
+
+        entries.append(IMAGE.pack(name.encode(), len(frames), frame_time, len(colors), colors_offset, frames_offset))
+
+    HEADER.pack_into(data, 0, LIBRARY_MAGIC, LIBRARY_VERSION, len(images), len(data))
+    for idx, entry in enumerate(entries):
+        data[HEADER.size + IMAGE.size * idx:HEADER.size + IMAGE.size * (idx + 1)] = entry
+    return bytes(data)
+
+
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('output', help='library binary to write')
+    parser.add_argument('--image', nargs='+', action='append', default=[], metavar=('NAME[:MS]', 'PNG'),
+                        help='an image, or an animation shown MS milliseconds a frame when given several PNGs')
+    parser.add_argument('--regions', metavar='IMAGES_CPP',
+                        help='also pack the built-in regions from images.cpp as an image called "regions"')
+    parser.add_argument('--palette', default='', metavar='RRGGBB,...',
+                        help='colors to give the first labels, in order, ahead of those found in the PNGs')
+    args = parser.parse_args()
+
+    palette = [int(value, 16) for value in args.palette.split(',') if value]
+    images = []
+
+    if args.regions:
+        columns, colors = label_regions(args.regions)
+        images.append(('regions', 0, colors, [columns]))
+
+    for spec in args.image:
+        if len(spec) < 2:
+            parser.error('--image needs a name and at least one PNG')
+        name, _, frame_time = spec[0].partition(':')
+        colors = list(palette)
+        frames = [label_png(path, colors) for path in spec[1:]]
+        images.append((name, int(frame_time or 0), colors, frames))
+
+    for name, _, colors, _ in images:
+        if len(name.encode()) > LIBRARY_NAME_SIZE:
+            raise SystemExit(f'image name "{name}" is longer than {LIBRARY_NAME_SIZE} characters')
+        if len(colors) >= PALETTE_SIZE:
+            raise SystemExit(f'image "{name}" has {len(colors)} colors, at most {PALETTE_SIZE - 1} are supported')
+    if len(set(name for name, _, _, _ in images)) != len(images):
+        raise SystemExit('image names must be unique')
+
+    library = pack(images)
+    if len(library) > LIBRARY_FLASH_SIZE:
+        raise SystemExit(f'library is {len(library)} bytes, the flash range only holds {LIBRARY_FLASH_SIZE}')
+    with open(args.output, 'wb') as file:
+        file.write(library)
+
+    raw = sum(len(frames) for _, _, _, frames in images) * RES_HORIZ * RES_VERT
+    print(f'{len(images)} images, {len(library)} bytes written to {args.output} ({raw} bytes of labels unpacked)')
+
+
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+# =====================================================================================================================
+#      File:  /tools/labelgen.py
+#   Project:  POV Globe
+# ---------------------------------------------------------------------------------------------------------------------
+"""Flatten the region masks in images.cpp into the single label plane used by IMAGE_FORMAT_LABELS.
+
+Regions never overlap, so every pixel holds the number of the region it belongs to plus one, or 0 where there is no
+region.  The columns each region covers are written alongside so the renderer knows what to redraw when a region
+changes.  Run from the repository root:
+
+    python tools/labelgen.py src/images.cpp src/labels.cpp
+"""
+import argparse
+
+from spangen import REGION_HEIGHT, parse_regions
+
+
+
+
+def build_labels(regions):
+    """Return the label plane as a list of columns, failing if any two regions claim the same pixel."""
+    width = len(regions[0][1])
+    labels = [[0] * REGION_HEIGHT for _ in range(width)]
+
+    for number, (name, bitmap) in enumerate(regions, start=1):
+        for column, values in enumerate(bitmap):
+            for row in range(REGION_HEIGHT):
+                if values[row // 8] & (0x80 >> (row % 8)):
+                    if labels[column][row]:
+                        raise SystemExit(f'{name} overlaps region {labels[column][row]} at column {column} row {row}')
+                    labels[column][row] = number
+    return labels
+
+
+
+
+def generate(regions, labels):
+    lines = [
+        '// This file was generated by tools/labelgen.py from src/images.cpp, do not edit it by hand.',
+        '',
+        '#include <Arduino.h>',
+        '#include "images.h"',
+        '',
+        'const LabelMap_t LabelMap = {',
+    ]
+    for column in labels:
+        lines.append('\t{ ' + ', '.join(str(label) for label in column) + ' },')
+    lines.append('};')
+    lines.append('')
+    lines.append('')
+    lines.append('const RegionExtent_t RegionExtents[REGION_COUNT] = {')
+
+    for number, (name, _) in enumerate(regions, start=1):
+        used = [idx for idx, column in enumerate(labels) if number in column]
+        if used:
+            lines.append(f'\t{{ {used[0]}, {used[-1] - used[0] + 1} }},  // {name}')
+        else:
+            lines.append(f'\t{{ 0, 0 }},  // {name}')
+
+    lines.append('};')
+    lines.append('')
+    return '\n'.join(lines)
+
+
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('images', help='images.cpp holding the Region_t bitmaps')
+    parser.add_argument('output', help='label map source file to write')
+    args = parser.parse_args()
+
+    with open(args.images, newline='') as file:
+        regions = parse_regions(file.read().replace('\r\n', '\n'))
+
+    labels = build_labels(regions)
+    with open(args.output, 'w', newline='\r\n') as file:
+        file.write(generate(regions, labels))
+
+    covered = sum(1 for column in labels for label in column if label)
+    print(f'{len(regions)} regions, {covered} labelled pixels written to {args.output}')
+
+
+
+
+if __name__ == '__main__':
+    main()
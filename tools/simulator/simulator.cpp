@@ -0,0 +1,411 @@
+/* =====================================================================================================================
+ *      File:  /tools/simulator/simulator.cpp
+ *   Project:  POV Globe
+ *    Author:  Jared Julien <jaredjulien@exsystems.net>
+ * Copyright:  (c) 2024 Jared Julien, eX Systems
+ * ---------------------------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ---------------------------------------------------------------------------------------------------------------------
+ */
+// =====================================================================================================================
+// Includes
+// ---------------------------------------------------------------------------------------------------------------------
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+#include <vector>
+
+#include "Arduino.h"
+#include "hardware/gpio.h"
+#include "native.h"
+
+#include "animation.h"
+#include "constants.h"
+#include "frame.h"
+#include "library.h"
+#include "pins.h"
+#include "renderer.h"
+#include "rtt.h"
+
+
+
+
+//======================================================================================================================
+// Definitions
+//----------------------------------------------------------------------------------------------------------------------
+#if COLUMN_OUTPUT == COLUMN_OUTPUT_STREAMED
+#error "The simulator only models COLUMN_OUTPUT_POLLED, DREQ pacing is not emulated on the host"
+#endif
+
+#define DEGREES_PER_COLUMN (360.0 / RES_HORIZ)
+
+
+
+
+//======================================================================================================================
+// Type Definitions
+//----------------------------------------------------------------------------------------------------------------------
+typedef struct
+{
+	double rpm;
+	double jitter_us;
+	uint32_t revolutions;
+	uint32_t warmup;
+	uint32_t step_us;
+	uint32_t scale;
+	uint32_t seed;
+	const char * output;
+	const char * library;
+	const char * image;
+} Options_t;
+
+// One column as it left the strip: where the strip really was and the colors it showed, top row first.
+typedef struct
+{
+	double angle;
+	uint32_t rgb[LED_COUNT];
+} Emission_t;
+
+
+
+
+//======================================================================================================================
+// Module Variables
+//----------------------------------------------------------------------------------------------------------------------
+// LED DMA channels, claimed by setup1() in main.cpp.
+extern uint8_t led_a_dma;
+extern uint8_t led_b_dma;
+
+static Options_t _options = { 720.0, 0.0, 50, 5, 5, 4, 1, "globe.ppm", NULL, NULL };
+static double _period_us;
+
+// True angle of the strip, in revolutions since the first index pulse, at the current simulated time.
+static double _revolution;
+
+static std::vector<Emission_t> _current[2];
+static std::vector<Emission_t> _completed[2];
+static uint32_t _completed_revolution;
+
+static uint32_t _samples;
+static double _error_sum;
+static double _error_sum_squares;
+static double _error_max;
+
+
+
+
+//======================================================================================================================
+// Helpers
+//----------------------------------------------------------------------------------------------------------------------
+/* Decode a column in output format back into 24-bit RGB, top row of the half first. */
+static void _decode_column(const uint32_t * data, uint32_t * rgb)
+{
+	for (uint8_t idx = 0; idx < LED_COUNT; idx++)
+	{
+		// The row pair index runs from the far end of the strip, see frame_set_pixel().
+#if PIXEL_FORMAT == PIXEL_FORMAT_RGB555
+		uint8_t position = LED_COUNT - 1 - idx;
+		uint32_t pixel = (data[position / 2] >> ((position & 1) * 16)) & 0x7FFF;
+		uint32_t red = (pixel & 0x1F) << 3;
+		uint32_t green = ((pixel >> 5) & 0x1F) << 3;
+		uint32_t blue = ((pixel >> 10) & 0x1F) << 3;
+#else
+		uint32_t pixel = data[LED_COUNT - idx];
+		uint32_t red = pixel & 0xFF;
+		uint32_t green = (pixel >> 8) & 0xFF;
+		uint32_t blue = (pixel >> 16) & 0xFF;
+#endif
+		rgb[idx] = red << 16 | green << 8 | blue;
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Record every column handed to the LED DMA while the globe is tracking. */
+static void _dma_listener(uint channel, volatile void * write_addr, const uint32_t * data, uint32_t count)
+{
+	(void)write_addr;
+
+	if (((channel != led_a_dma) && (channel != led_b_dma)) || (count != COLUMN_WORDS) || !rtt_rotating())
+	{
+		return;
+	}
+
+	// Columns are sent as the phase, turned by the rotation offset, reaches them, so the tracker's idea of the angle
+	// when the left half went out is where the strip should really have been.
+	if ((channel == led_a_dma) && (_revolution >= _options.warmup))
+	{
+		double fraction = _revolution - floor(_revolution);
+		double error = fraction * 360.0 - rtt_phase() * DEGREES_PER_COLUMN / (1 << RTT_PHASE_SHIFT);
+		error = error - 360.0 * floor((error + 180.0) / 360.0);
+
+		_samples++;
+		_error_sum += error;
+		_error_sum_squares += error * error;
+		if (fabs(error) > _error_max)
+		{
+			_error_max = fabs(error);
+		}
+	}
+
+	// The right half is on the opposite side of the globe.
+	uint8_t side = (channel == led_a_dma) ? 0 : 1;
+	Emission_t emission;
+	emission.angle = (_revolution - floor(_revolution)) * 360.0 + side * 180.0;
+	_decode_column(data, emission.rgb);
+	_current[side].push_back(emission);
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Keep the emissions of the most recent complete revolution and start collecting the next. */
+static void _complete_revolution(uint32_t revolution)
+{
+	for (uint8_t side = 0; side < 2; side++)
+	{
+		_completed[side].swap(_current[side]);
+		_current[side].clear();
+	}
+	_completed_revolution = revolution;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+/* Paint the last complete revolution into an equirectangular image, each column lit for one column width from the
+ * angle the strip was really at.  Columns that overlap are overwritten and gaps stay black, as a camera would see it.
+ */
+static bool _write_image(const char * path)
+{
+	uint32_t width = RES_HORIZ * _options.scale;
+	std::vector<uint32_t> image(width * RES_VERT, 0);
+
+	for (uint8_t side = 0; side < 2; side++)
+	{
+		for (const Emission_t & emission : _completed[side])
+		{
+			uint32_t start = (uint32_t)lround(emission.angle / 360.0 * width);
+			for (uint32_t x = start; x < start + _options.scale; x++)
+			{
+				for (uint8_t idx = 0; idx < LED_COUNT; idx++)
+				{
+					uint8_t row = 2 * idx + (side == 0 ? 1 : 0);
+					image[row * width + (x % width)] = emission.rgb[idx];
+				}
+			}
+		}
+	}
+
+	FILE * file = fopen(path, "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	fprintf(file, "P6\n%u %u\n255\n", width, RES_VERT);
+	for (uint32_t pixel : image)
+	{
+		uint8_t bytes[3] = { (uint8_t)(pixel >> 16), (uint8_t)(pixel >> 8), (uint8_t)pixel };
+		fwrite(bytes, 1, sizeof(bytes), file);
+	}
+
+	return fclose(file) == 0;
+}
+
+
+//----------------------------------------------------------------------------------------------------------------------
+static bool _parse_options(int argc, char ** argv)
+{
+	for (int idx = 1; idx < argc; idx++)
+	{
+		const char * arg = argv[idx];
+		const char * value = strchr(arg, '=');
+		if (!value)
+		{
+			return false;
+		}
+		value++;
+
+		if (!strncmp(arg, "--rpm=", 6))
+		{
+			_options.rpm = atof(value);
+		}
+		else if (!strncmp(arg, "--jitter=", 9))
+		{
+			_options.jitter_us = atof(value);
+		}
+		else if (!strncmp(arg, "--revolutions=", 14))
+		{
+			_options.revolutions = strtoul(value, NULL, 0);
+		}
+		else if (!strncmp(arg, "--warmup=", 9))
+		{
+			_options.warmup = strtoul(value, NULL, 0);
+		}
+		else if (!strncmp(arg, "--step=", 7))
+		{
+			_options.step_us = strtoul(value, NULL, 0);
+		}
+		else if (!strncmp(arg, "--scale=", 8))
+		{
+			_options.scale = strtoul(value, NULL, 0);
+		}
+		else if (!strncmp(arg, "--seed=", 7))
+		{
+			_options.seed = strtoul(value, NULL, 0);
+		}
+		else if (!strncmp(arg, "--output=", 9))
+		{
+			_options.output = value;
+		}
+		else if (!strncmp(arg, "--library=", 10))
+		{
+			_options.library = value;
+		}
+		else if (!strncmp(arg, "--image=", 8))
+		{
+			_options.image = value;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	return (_options.rpm > 0) && (_options.step_us > 0) && (_options.scale > 0)
+		&& (_options.revolutions > _options.warmup);
+}
+
+
+
+
+//======================================================================================================================
+// Entry Point
+//----------------------------------------------------------------------------------------------------------------------
+/* Spin a virtual globe under the firmware.
+ *
+ * Hall pulses arrive once per revolution at the requested speed, each displaced by gaussian jitter, while loop1() is
+ * polled every step.  The strip's true angle is known exactly so every column the firmware emits can be placed where
+ * a viewer would really see it and compared against where the firmware meant to put it.
+ */
+int main(int argc, char ** argv)
+{
+	if (!_parse_options(argc, argv))
+	{
+		fprintf(stderr, "usage: %s [--rpm=720] [--jitter=0] [--revolutions=50] [--warmup=5] [--step=5] [--scale=4] "
+			"[--seed=1] [--output=globe.ppm] [--library=library.bin] [--image=name]\n", argv[0]);
+		return 2;
+	}
+
+	_period_us = 60e6 / _options.rpm;
+
+	native_time_manual(true);
+	native_time_set_us(0);
+	native_set_dma_listener(_dma_listener);
+
+	// The library goes where picotool would write it, for setup1() to find.
+	if (_options.library && !native_flash_load(LIBRARY_FLASH_OFFSET, _options.library))
+	{
+		fprintf(stderr, "failed to load %s into flash\n", _options.library);
+		return 1;
+	}
+
+	setup();
+	setup1();
+
+	if (_options.image)
+	{
+		const LibraryImage_t * image = library_find(_options.image, strlen(_options.image));
+		if (!image)
+		{
+			fprintf(stderr, "no image called %s in the library\n", _options.image);
+			return 1;
+		}
+		animation_play(image);
+	}
+
+	std::mt19937 generator(_options.seed);
+	std::normal_distribution<double> jitter(0.0, _options.jitter_us);
+
+	// The first pulse comes a little after boot so the filter starts from a realistic timestamp.
+	const double start_us = 1000.0;
+	uint32_t pulse = 0;
+	double next_pulse = start_us;
+	uint32_t revolution = 0;
+
+	uint64_t end_us = (uint64_t)(start_us + _period_us * (_options.revolutions + 1));
+	for (uint64_t now = 0; now < end_us; now += _options.step_us)
+	{
+		while (next_pulse <= now)
+		{
+			native_time_set_us((uint64_t)next_pulse);
+			_revolution = (next_pulse - start_us) / _period_us;
+			native_gpio_event(PIN_HALL, GPIO_IRQ_EDGE_FALL);
+
+			pulse++;
+			double jittered = start_us + pulse * _period_us + (_options.jitter_us > 0 ? jitter(generator) : 0.0);
+			next_pulse = jittered > next_pulse ? jittered : next_pulse + 1.0;
+		}
+
+		native_time_set_us(now);
+		_revolution = (now - start_us) / _period_us;
+		if ((now >= start_us) && ((uint32_t)_revolution != revolution))
+		{
+			revolution = (uint32_t)_revolution;
+			_complete_revolution(revolution - 1);
+		}
+
+		loop1();
+		loop();
+	}
+
+	if (!_samples)
+	{
+		fprintf(stderr, "no columns were emitted after warm-up, is %.0f RPM within the tracking range?\n", _options.rpm);
+		return 1;
+	}
+
+	double mean = _error_sum / _samples;
+	double rms = sqrt(_error_sum_squares / _samples);
+	printf("rpm %.1f, jitter %.1f us, %u revolutions (%u warm-up), poll step %u us\n", _options.rpm, _options.jitter_us,
+		_options.revolutions, _options.warmup, _options.step_us);
+	printf("columns %u, placement error mean %+.3f deg, rms %.3f deg, max %.3f deg (column pitch %.3f deg)\n", _samples,
+		mean, rms, _error_max, DEGREES_PER_COLUMN);
+
+	const RendererStats_t * frames = renderer_stats();
+	printf("frames published %u, shown %u, skipped %u, deferred %u\n", frames->published, frames->shown, frames->skipped,
+		frames->deferred);
+	if (animation_playing())
+	{
+		const AnimationStats_t * animation = animation_stats();
+		printf("animation frames %u, dropped %u, deferred %u, late %u (worst %u us), render max %u us\n",
+			animation->frames, animation->dropped, animation->deferred, animation->late, animation->late_max_us,
+			animation->render_max_us);
+	}
+
+	if (!_write_image(_options.output))
+	{
+		fprintf(stderr, "failed to write %s\n", _options.output);
+		return 1;
+	}
+	printf("revolution %u written to %s\n", _completed_revolution, _options.output);
+
+	return 0;
+}
+
+
+
+
+/* End of File */
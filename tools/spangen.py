@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+# =====================================================================================================================
+#      File:  /tools/spangen.py
+#   Project:  POV Globe
+# ---------------------------------------------------------------------------------------------------------------------
+"""Convert the bit-per-pixel region masks in images.cpp into the span tables used by the renderer.
+
+Each region becomes a run of columns, from its first to its last non-empty column, with the vertical runs of set pixels
+in every column listed as (row, length) pairs.  Run from the repository root:
+
+    python tools/spangen.py src/images.cpp src/spans.cpp
+"""
+import argparse
+import re
+
+
+REGION_HEIGHT = 47
+
+REGION_PATTERN = re.compile(r'const Region_t (\w+) = \{(.*?)\n\};', re.S)
+ROW_PATTERN = re.compile(r'\{([^{}]*)\}')
+ORDER_PATTERN = re.compile(r'Regions\[REGION_COUNT\] = \{(.*?)\};', re.S)
+
+
+
+
+def parse_regions(source):
+    """Return the region bitmaps, each a list of columns of byte values, in Regions[] order."""
+    bitmaps = {}
+    for name, body in REGION_PATTERN.findall(source):
+        bitmaps[name] = [[int(value, 0) for value in row.split(',') if value.strip()]
+                         for row in ROW_PATTERN.findall(body)]
+
+    order = re.findall(r'&(\w+)', ORDER_PATTERN.search(source).group(1))
+    return [(name, bitmaps[name]) for name in order]
+
+
+
+
+def column_spans(column):
+    """Find the (row, length) runs of set pixels in one column, MSB of the first byte being row 0."""
+    spans = []
+    start = None
+    for row in range(REGION_HEIGHT + 1):
+        lit = row < REGION_HEIGHT and bool(column[row // 8] & (0x80 >> (row % 8)))
+        if lit and start is None:
+            start = row
+        elif not lit and start is not None:
+            spans.append((start, row - start))
+            start = None
+    return spans
+
+
+
+
+def generate(regions):
+    lines = [
+        '// This file was generated by tools/spangen.py from src/images.cpp, do not edit it by hand.',
+        '',
+        '#include <Arduino.h>',
+        '#include "images.h"',
+        '',
+    ]
+    entries = []
+    total = 0
+
+    for name, bitmap in regions:
+        columns = [column_spans(column) for column in bitmap]
+        used = [idx for idx, spans in enumerate(columns) if spans]
+        if not used:
+            entries.append(f'\t{{ 0, 0, NULL, NULL }},  // {name}')
+            continue
+
+        first, last = used[0], used[-1]
+        index = [0]
+        span_lines = []
+        for spans in columns[first:last + 1]:
+            index.append(index[-1] + len(spans))
+            span_lines.append('\t' + ' '.join(f'{{ {row}, {length} }},' for row, length in spans))
+        total += index[-1]
+
+        lines.append(f'static const uint16_t {name}Index[] = {{')
+        for offset in range(0, len(index), 16):
+            lines.append('\t' + ' '.join(f'{value},' for value in index[offset:offset + 16]))
+        lines.append('};')
+        lines.append('')
+        lines.append(f'static const Span_t {name}Spans[] = {{')
+        lines.extend(line for line in span_lines if line.strip())
+        lines.append('};')
+        lines.append('')
+        lines.append('')
+        entries.append(f'\t{{ {first}, {last - first + 1}, {name}Index, {name}Spans }},')
+
+    lines.append('const RegionSpans_t RegionSpans[REGION_COUNT] = {')
+    lines.extend(entries)
+    lines.append('};')
+    lines.append('')
+    return '\n'.join(lines), total
+
+
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('images', help='images.cpp holding the Region_t bitmaps')
+    parser.add_argument('output', help='span table source file to write')
+    args = parser.parse_args()
+
+    with open(args.images, newline='') as file:
+        regions = parse_regions(file.read().replace('\r\n', '\n'))
+
+    source, total = generate(regions)
+    with open(args.output, 'w', newline='\r\n') as file:
+        file.write(source)
+
+    print(f'{len(regions)} regions, {total} spans written to {args.output}')
+
+
+
+
+if __name__ == '__main__':
+    main()